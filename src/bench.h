@@ -0,0 +1,350 @@
+#pragma once
+
+#include "ofMain.h"
+#include "effects.h"
+#include "pipeline.h"
+#include "history.h"
+#include "renderers.h"
+#include "cellstream.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// ---------------------------------------------------------------------------
+// Benchmark mode — times the remap path and ASCII cell building headless.
+//
+//   ofxFilters --bench [--bench-out results.json] [--baseline base.json]
+//                      [--tolerance 10] [--bench-frames 30] [--threads N]
+//                      [--bench-gl]
+//
+// For 640x480, 1280x720 and 1920x1080:
+//   remap/<chain>        every subset of the default chain (Wave, Slitscan,
+//                        BlockDisplace, RgbSplit, in setup() order) through
+//                        EffectChain::process(), exactly as update() runs it;
+//                        "remap/none" is the bare gather. Live chains run
+//                        the fused kernel; "remap/<chain>/generic" times
+//                        the same chain through the span loop;
+//                        "remap/<chain>/subpixel" has Wave and Slitscan in
+//                        sub-pixel mode (bilinear + temporal gather)
+//   remap/Feedback       FeedbackEffect alone over a previous output, in
+//                        pixel and ("/subpixel") blend mode
+//   ascii/cellW=N/mode=M AsciiRenderer::buildCells() at display size = frame;
+//                        a trailing "/area" marks summed-area sampling
+//   asciimesh/cellW=N/mode=M  buildCells() + buildMesh(), everything render()
+//                        does before the single draw call
+//   ingest/rgba          FrameIngest, same-size RGBA → RGB
+//   ingest/4k-rgba       FrameIngest, 3840x2160 RGBA scaled to the frame size
+//   stream/<format>/mode=M  AsciiStreamRenderer::encodeFrame(), ANSI or
+//                        binary, on frames that alternate between two
+//                        inputs, so most cells are re-sent every frame
+//   upload/pbo, upload/direct  TextureRenderer upload with and without the
+//                        PBO path, main-thread time only (as the
+//                        render/Texture/upload stage); only with --bench-gl,
+//                        which opens a hidden window for a GL context
+//
+// Each case reports the median over --bench-frames frames as ns/pixel and
+// frames/sec. Results are printed and written as JSON. With --baseline,
+// any case more than --tolerance percent slower (by ns/pixel) than the
+// baseline fails the run (exit code 1).
+//
+// Every remap and ingest case is also run once with scalar kernels (and the
+// generic span loop); a SIMD or fused output that differs from that
+// reference fails the run as well.
+// ---------------------------------------------------------------------------
+struct BenchOptions {
+    std::string outPath;
+    std::string baselinePath;
+    float tolerance = 10.0f;
+    int   frames    = 30;
+    int   threads   = 0;
+    bool  gl        = false;
+};
+
+inline bool parseBenchArgs(int argc, char* argv[], BenchOptions& o) {
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if      (a == "--bench")                      bench = true;
+        else if (a == "--bench-out"    && hasValue)   o.outPath      = argv[++i];
+        else if (a == "--baseline"     && hasValue)   o.baselinePath = argv[++i];
+        else if (a == "--tolerance"    && hasValue)   o.tolerance    = ofToFloat(argv[++i]);
+        else if (a == "--bench-frames" && hasValue)   o.frames       = std::max(1, ofToInt(argv[++i]));
+        else if (a == "--threads"      && hasValue)   o.threads      = ofToInt(argv[++i]);
+        else if (a == "--bench-gl")                   o.gl           = true;
+    }
+    return bench;
+}
+
+struct BenchResult {
+    std::string name;
+    int    width, height;
+    double nsPerPixel, fps;
+};
+
+// Median wall time of `frames` calls to fn(frameIndex), after two warm-ups.
+template <typename Fn>
+inline double benchMedianNs(int frames, Fn fn) {
+    using Clock = std::chrono::steady_clock;
+    fn(-2);
+    fn(-1);
+    std::vector<double> ns(frames);
+    for (int i = 0; i < frames; i++) {
+        auto t0 = Clock::now();
+        fn(i);
+        ns[i] = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    }
+    std::nth_element(ns.begin(), ns.begin() + frames / 2, ns.end());
+    return ns[frames / 2];
+}
+
+inline int runBench(const BenchOptions& o) {
+    const int sizes[][2] = { {640, 480}, {1280, 720}, {1920, 1080} };
+
+    WorkerPool pool(o.threads);
+    std::vector<BenchResult> results;
+    bool kernelsMatch = true;
+    std::mt19937 rng(1234);
+
+    if (o.gl) {
+        ofGLFWWindowSettings settings;
+        settings.setSize(64, 64);
+        settings.visible = false;
+        ofCreateWindow(settings);
+    }
+
+    for (auto& size : sizes) {
+        int w = size[0], h = size[1];
+        size_t bytes = (size_t)w * h * 3;
+
+        // 60 full frames of noise, as after a second of live input
+        FrameHistory history;
+        history.configure(w, h, bytes * 60 / (1024.0f * 1024.0f) + 1, 60, FrameHistory::Full);
+        std::vector<unsigned char> noise(bytes);
+        ofPixels px;
+        for (int i = 0; i < history.recentDepth(); i++) {
+            for (auto& b : noise) b = (unsigned char)rng();
+            px.setFromPixels(noise.data(), w, h, OF_PIXELS_RGB);
+            history.pushPixels(px);
+        }
+
+        WaveEffect          wave;
+        SlitscanEffect      slitscan(history.depth());
+        BlockDisplaceEffect block;
+        RgbSplitEffect      rgb;
+        EffectChain chain;
+        chain.modules = { &wave, &slitscan, &block, &rgb };
+
+        std::vector<unsigned char> out(bytes), reference(bytes);
+
+        // Every subset, then the ones with Wave or Slitscan again in sub-pixel mode
+        for (int c = 0; c < 32; c++) {
+            int  mask = c & 15;
+            bool sub  = c >= 16;
+            if (sub && !(mask & 3)) continue;
+            wave.subpixel = slitscan.subpixel = sub;
+
+            std::string name;
+            for (int m = 0; m < 4; m++) {
+                chain.modules[m]->enabled = (mask >> m) & 1;
+                if (chain.modules[m]->enabled) {
+                    name += (name.empty() ? "" : "+") + chain.modules[m]->name;
+                }
+            }
+            if (name.empty()) name = "none";
+            if (sub) name += "/subpixel";
+
+            auto frameAt = [&](int i, unsigned char* dst) {
+                RemapFrame f = { history.byAge(), history.recentDepth(), history.depth(), &history,
+                                 dst, w, h, (i + 2) / 60.0f };
+                chain.process(f, pool);
+            };
+
+            // Drop any baked table so both kernel sets really run the chain.
+            // The reference is the generic span loop with scalar kernels.
+            useSimdKernels(false);
+            chain.useFused  = false;
+            chain.lut.valid = false;
+            frameAt(0, reference.data());
+            useSimdKernels(true);
+            chain.useFused  = true;
+            chain.lut.valid = false;
+            frameAt(0, out.data());
+            if (out != reference) {
+                std::fprintf(stderr, "bench: %s kernels differ from scalar on remap/%s at %dx%d\n",
+                             chain.usingFused() ? "fused" : remapKernels().name, name.c_str(), w, h);
+                kernelsMatch = false;
+            }
+
+            double ns = benchMedianNs(o.frames, [&](int i) { frameAt(i, out.data()); });
+            results.push_back({ "remap/" + name, w, h, ns / ((double)w * h), 1e9 / ns });
+
+            if (chain.usingFused()) {
+                chain.useFused = false;
+                ns = benchMedianNs(o.frames, [&](int i) { frameAt(i, out.data()); });
+                results.push_back({ "remap/" + name + "/generic", w, h, ns / ((double)w * h), 1e9 / ns });
+                chain.useFused = true;
+            }
+        }
+
+        // Feedback over a noise "previous output". Its dither pattern moves
+        // every frame, so the scalar reference runs on a module of its own.
+        std::vector<unsigned char> previous(bytes);
+        for (auto& b : previous) b = (unsigned char)rng();
+        for (bool sub : { false, true }) {
+            FeedbackEffect feedback, feedbackRef;
+            feedback.zoom     = feedbackRef.zoom     = 1.05f;
+            feedback.subpixel = feedbackRef.subpixel = sub;
+            EffectChain fbChain, fbReference;
+            fbChain.modules     = { &feedback };
+            fbReference.modules = { &feedbackRef };
+            std::string name = std::string("remap/Feedback") + (sub ? "/subpixel" : "");
+
+            auto frameAt = [&](EffectChain& c, int i, unsigned char* dst) {
+                RemapFrame f = { history.byAge(), history.recentDepth(), history.depth(), &history,
+                                 dst, w, h, (i + 2) / 60.0f, previous.data() };
+                c.process(f, pool);
+            };
+            useSimdKernels(false);
+            frameAt(fbReference, 0, reference.data());
+            useSimdKernels(true);
+            frameAt(fbChain, 0, out.data());
+            if (out != reference) {
+                std::fprintf(stderr, "bench: %s kernels differ from scalar on %s at %dx%d\n",
+                             remapKernels().name, name.c_str(), w, h);
+                kernelsMatch = false;
+            }
+            double ns = benchMedianNs(o.frames, [&](int i) { frameAt(fbChain, i, out.data()); });
+            results.push_back({ name, w, h, ns / ((double)w * h), 1e9 / ns });
+        }
+
+        // Decoded-frame ingest
+        ofPixels rgba, rgba4k;
+        rgba.allocate(w, h, OF_PIXELS_RGBA);
+        rgba4k.allocate(3840, 2160, OF_PIXELS_RGBA);
+        for (auto* p : { &rgba, &rgba4k }) {
+            for (size_t i = 0; i < p->size(); i++) p->getData()[i] = (unsigned char)rng();
+        }
+        std::vector<unsigned char> ingested(bytes);
+        for (auto* p : { &rgba, &rgba4k }) {
+            std::string name = p == &rgba ? "ingest/rgba" : "ingest/4k-rgba";
+            FrameIngest ingest;
+            ingest.kernels = &scalarIngestKernels();
+            ingest.convert(*p, reference.data(), w, h);
+            ingest.kernels = &bestIngestKernels();
+            ingest.convert(*p, ingested.data(), w, h);
+            if (std::memcmp(ingested.data(), reference.data(), bytes) != 0) {
+                std::fprintf(stderr, "bench: %s kernels differ from scalar on %s at %dx%d\n",
+                             ingest.kernels->name, name.c_str(), w, h);
+                kernelsMatch = false;
+            }
+            double ns = benchMedianNs(o.frames, [&](int) { ingest.convert(*p, ingested.data(), w, h); });
+            results.push_back({ name, w, h, ns / ((double)w * h), 1e9 / ns });
+        }
+
+        AsciiRenderer ascii;
+        for (int cellW : { 4, 8, 16, 32 }) {
+            for (int mode = 0; mode < 3; mode++) {
+                for (bool area : { false, true }) {
+                    ascii.cellW      = cellW;
+                    ascii.colorMode  = mode;
+                    ascii.areaSample = area;
+                    std::string suffix = "cellW=" + ofToString(cellW) + "/mode=" + ofToString(mode)
+                                       + (area ? "/area" : "");
+                    double ns = benchMedianNs(o.frames, [&](int) {
+                        ascii.buildCells(out.data(), w, h, (float)w, (float)h);
+                    });
+                    results.push_back({ "ascii/" + suffix, w, h, ns / ((double)w * h), 1e9 / ns });
+
+                    ns = benchMedianNs(o.frames, [&](int) {
+                        ascii.buildCells(out.data(), w, h, (float)w, (float)h);
+                        ascii.buildMesh(0, 0);
+                    });
+                    results.push_back({ "asciimesh/" + suffix, w, h, ns / ((double)w * h), 1e9 / ns });
+                }
+            }
+        }
+
+        // Cell stream encoding, no sink
+        const unsigned char* inputs[2] = { out.data(), history.byAge()[0] };
+        for (auto format : { AsciiStreamRenderer::Ansi, AsciiStreamRenderer::Binary }) {
+            for (int mode : { 0, 2 }) {
+                ascii.cellW      = 8;
+                ascii.colorMode  = mode;
+                ascii.areaSample = false;
+                AsciiStreamRenderer stream;
+                stream.format = format;
+                stream.follow = &ascii;
+                std::string name = std::string("stream/") + (format == AsciiStreamRenderer::Ansi ? "ansi" : "binary")
+                                 + "/mode=" + ofToString(mode);
+                double ns = benchMedianNs(o.frames, [&](int i) {
+                    stream.encodeFrame(inputs[i & 1], w, h, (float)w, (float)h);
+                });
+                results.push_back({ name, w, h, ns / ((double)w * h), 1e9 / ns });
+            }
+        }
+
+        // Texture upload, consecutive frames from different buffers as in
+        // the app
+        if (o.gl) {
+            for (bool pbo : { true, false }) {
+                TextureRenderer texture;
+                texture.usePbo = pbo;
+                texture.allocate(w, h);
+                if (pbo && !texture.pboActive()) {
+                    std::fprintf(stderr, "bench: no PBO support, upload/pbo skipped\n");
+                    continue;
+                }
+                double ns = benchMedianNs(o.frames, [&](int i) {
+                    texture.render(inputs[i & 1], w, h, 0, 0, (float)w, (float)h);
+                });
+                results.push_back({ pbo ? "upload/pbo" : "upload/direct", w, h,
+                                    ns / ((double)w * h), 1e9 / ns });
+            }
+        }
+    }
+
+    // Report
+    ofJson json;
+    json["threads"] = pool.threadCount();
+    json["kernels"] = remapKernels().name;
+    json["ingestKernels"] = bestIngestKernels().name;
+    json["frames"]  = o.frames;
+    json["results"] = ofJson::array();
+    for (auto& r : results) {
+        std::printf("%-44s %5dx%-5d %9.3f ns/px %9.1f fps\n",
+                    r.name.c_str(), r.width, r.height, r.nsPerPixel, r.fps);
+        json["results"].push_back({ {"name", r.name}, {"width", r.width}, {"height", r.height},
+                                    {"nsPerPixel", r.nsPerPixel}, {"fps", r.fps} });
+    }
+    if (!o.outPath.empty()) {
+        ofSavePrettyJson(ofFilePath::getAbsolutePath(o.outPath, false), json);
+    }
+
+    // Compare against baseline
+    int regressions = 0;
+    if (!o.baselinePath.empty()) {
+        ofJson base = ofLoadJson(ofFilePath::getAbsolutePath(o.baselinePath, false));
+        if (!base.contains("results")) {
+            std::fprintf(stderr, "bench: cannot read baseline '%s'\n", o.baselinePath.c_str());
+            return 1;
+        }
+        for (auto& r : results) {
+            for (auto& b : base["results"]) {
+                if (b.value("name", "") != r.name || b.value("width", 0) != r.width
+                                                  || b.value("height", 0) != r.height) continue;
+                double before = b.value("nsPerPixel", 0.0);
+                double slower = before > 0 ? (r.nsPerPixel / before - 1.0) * 100.0 : 0.0;
+                if (slower > o.tolerance) {
+                    std::printf("REGRESSION %-36s %5dx%-5d %+.1f%% (%.3f -> %.3f ns/px)\n",
+                                r.name.c_str(), r.width, r.height, slower, before, r.nsPerPixel);
+                    regressions++;
+                }
+            }
+        }
+        std::printf("bench: %d regression(s) over %.1f%%\n", regressions, o.tolerance);
+    }
+
+    return (regressions > 0 || !kernelsMatch) ? 1 : 0;
+}
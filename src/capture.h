@@ -0,0 +1,189 @@
+#pragma once
+
+#include "ofMain.h"
+#include "history.h"
+#include "ingest.h"
+#include "profiler.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// FrameQueue — lock-free single-producer / single-consumer queue of w x h
+// RGB frames in borrowed buffers (a FrameHistory's spare slots). The
+// producer fills beginWrite() and publishes it with endWrite(); the consumer
+// reads front() and frees it with pop(). frontSlot() lets the consumer trade
+// the front buffer for another one before pop(), so frames move on without
+// a copy. A full queue makes beginWrite() return nullptr, never blocks.
+// allocate() must not race with either side.
+// ---------------------------------------------------------------------------
+struct FrameQueue {
+    // Capacity is buffers.size() - 1.
+    void allocate(int w, int h, const std::vector<unsigned char*>& buffers) {
+        width  = w;
+        height = h;
+        slots  = buffers;
+        head   = 0;
+        tail   = 0;
+    }
+
+    int getWidth()  const { return width; }
+    int getHeight() const { return height; }
+
+    // Producer side
+    unsigned char* beginWrite() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (slots.empty() || next(h) == tail.load(std::memory_order_acquire)) return nullptr;
+        return slots[h];
+    }
+    void endWrite() {
+        head.store(next(head.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    // Consumer side
+    const unsigned char* front() const {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (slots.empty() || t == head.load(std::memory_order_acquire)) return nullptr;
+        return slots[t];
+    }
+    unsigned char*& frontSlot() { return slots[tail.load(std::memory_order_relaxed)]; }
+    void pop() {
+        tail.store(next(tail.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+private:
+    std::vector<unsigned char*> slots;
+    std::atomic<size_t> head{0}, tail{0};
+    int width = 0, height = 0;
+
+    size_t next(size_t i) const { return (i + 1) % slots.size(); }
+};
+
+// ---------------------------------------------------------------------------
+// CaptureThread — converts/scales video or camera frames on a producer
+// thread, straight into the spare slots of the FrameHistory they are
+// queued for, so conversion never stalls update() or draw().
+//
+// The sources themselves stay on the main thread: update() calls their
+// update() and, when a frame is new, hands it to the producer, which reads
+// getPixels() and converts it. update() leaves the source alone until that
+// frame is converted, so the pixels never change under the producer.
+// Sources are set up with setUseTexture(false); only the history is drawn.
+//
+// With the thread stopped, update() converts the frame itself.
+// ---------------------------------------------------------------------------
+struct CaptureThread {
+    static const int kQueueFrames = 4;
+    static const int kSpareFrames = kQueueFrames + 1;   // FrameHistory spares
+
+    FrameQueue queue;
+
+    bool              useVideo = true;
+    bool              paused   = false;  // video only
+    std::atomic<int>  dropped{0};        // frames lost to a full queue
+
+    ~CaptureThread() { stop(); }
+
+    void setup(ofVideoPlayer* p, ofVideoGrabber* g) {
+        stop();
+        player  = p;
+        grabber = g;
+    }
+
+    // Queues frames into `history`'s spare slots (configured with
+    // kSpareFrames). Call with the thread stopped after every
+    // history.configure(); frames already queued are dropped if the
+    // history was re-laid out.
+    void bind(FrameHistory& history) {
+        if (history.layout() == boundLayout) return;
+        boundLayout = history.layout();
+        pending     = false;
+        queue.allocate(history.getWidth(), history.getHeight(), history.spares());
+    }
+
+    // Times update() as "capture/decode" and the conversion as
+    // "capture/convert".
+    void attachProfiler(Profiler* p) {
+        profiler = p;
+        if (!p) return;
+        decodeStage  = p->stage("capture/decode");
+        convertStage = p->stage("capture/convert");
+    }
+
+    void start() {
+        if (running()) return;
+        quit   = false;
+        thread = std::thread([this] {
+            while (!quit) {
+                if (!poll()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    void stop() {
+        if (!running()) return;
+        quit = true;
+        thread.join();
+    }
+
+    bool running() const { return thread.joinable(); }
+
+    // Main thread: updates the active source unless its last new frame is
+    // still waiting for the producer, and hands the next one over.
+    void update() {
+        if (!pending.load(std::memory_order_acquire)) {
+            if (playerPaused != paused) {
+                playerPaused = paused;
+                player->setPaused(playerPaused);
+            }
+            bool isNew;
+            {
+                ProfileScope scope(profiler, decodeStage);
+                if (useVideo) {
+                    player->update();
+                    isNew = player->isFrameNew();
+                } else {
+                    grabber->update();
+                    isNew = grabber->isFrameNew();
+                }
+            }
+            if (isNew) {
+                pendingVideo = useVideo;
+                pending.store(true, std::memory_order_release);
+            }
+        }
+        if (!running()) poll();
+    }
+
+    // Producer: converts the frame update() handed over into the queue.
+    // Returns false when there was nothing to convert.
+    bool poll() {
+        if (!pending.load(std::memory_order_acquire)) return false;
+        const ofPixels& px = pendingVideo ? player->getPixels() : grabber->getPixels();
+
+        if (unsigned char* slot = queue.beginWrite()) {
+            ProfileScope scope(profiler, convertStage);
+            ingest.convert(px, slot, queue.getWidth(), queue.getHeight());
+            queue.endWrite();
+        } else {
+            dropped++;
+        }
+        pending.store(false, std::memory_order_release);
+        return true;
+    }
+
+private:
+    ofVideoPlayer*    player  = nullptr;
+    ofVideoGrabber*   grabber = nullptr;
+    bool              playerPaused = false;
+    bool              pendingVideo = true;
+    std::atomic<bool> pending{false};    // a new source frame awaits poll()
+    unsigned          boundLayout = 0;
+    FrameIngest       ingest;
+    std::thread       thread;
+    std::atomic<bool> quit{false};
+
+    Profiler* profiler = nullptr;
+    int       decodeStage = -1, convertStage = -1;
+};
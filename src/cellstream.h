@@ -0,0 +1,451 @@
+#pragma once
+
+#include "ofMain.h"
+#include "renderers.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// StreamOptions — command-line setup of the ASCII cell stream.
+//
+//   ofxFilters --stream ansi                  ANSI to stdout
+//              --stream ansi:/tmp/led.sock    ANSI to a local socket
+//              --stream binary:/tmp/led.sock  binary deltas to a local socket
+//              [--stream-size 80x24] [--stream-fps 30] [--stream-bps 11520]
+//              [--stream-frame-bytes N]
+//
+// --stream-size fixes the grid (default: the on-screen ASCII grid);
+// --stream-bps caps bytes per second, --stream-frame-bytes bytes per frame.
+// ---------------------------------------------------------------------------
+struct StreamOptions {
+    std::string format;        // "ansi" or "binary"; empty = no stream
+    std::string socketPath;    // empty = stdout
+    int   columns    = 0;
+    int   rows       = 0;
+    float maxFps     = 30.0f;
+    int   bytesPerSecond = 0;
+    int   bytesPerFrame  = 0;
+};
+
+inline void parseStreamArgs(int argc, char* argv[], StreamOptions& o) {
+    for (int i = 1; i + 1 < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--stream") {
+            std::string v = argv[++i];
+            size_t colon  = v.find(':');
+            o.format     = v.substr(0, colon);
+            o.socketPath = colon == std::string::npos ? "" : v.substr(colon + 1);
+        }
+        else if (a == "--stream-fps")         o.maxFps         = ofToFloat(argv[++i]);
+        else if (a == "--stream-bps")         o.bytesPerSecond = ofToInt(argv[++i]);
+        else if (a == "--stream-frame-bytes") o.bytesPerFrame  = ofToInt(argv[++i]);
+        else if (a == "--stream-size") {
+            std::vector<std::string> cr = ofSplitString(argv[++i], "x");
+            if (cr.size() == 2) { o.columns = ofToInt(cr[0]); o.rows = ofToInt(cr[1]); }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// CellSink — byte output to stdout or a Unix domain socket.
+//
+// Socket writes never block: whatever the peer does not take stays in
+// `pending` and goes out first on the next flush(). A lost socket is
+// re-dialled at most once a second; `fresh` is set on every (re)connect so
+// the writer knows the receiver holds no state. stdout writes block, so
+// keep its byte budget within what the terminal can draw.
+// ---------------------------------------------------------------------------
+struct CellSink {
+    bool fresh = false;
+
+    bool openStdout() {
+        close();
+        fd = STDOUT_FILENO;
+        toStdout = true;
+        fresh    = true;
+        return true;
+    }
+
+    bool openSocket(const std::string& path) {
+        close();
+        socketPath = path;
+        return dial();
+    }
+
+    void close() {
+        if (fd >= 0 && !toStdout) ::close(fd);
+        fd = -1;
+        toStdout = false;
+        socketPath.clear();
+        pending.clear();
+        pendingOffset = 0;
+    }
+
+    bool isOpen() const { return toStdout || !socketPath.empty(); }
+    bool connected() const { return fd >= 0; }
+    size_t backlog() const { return pending.size() - pendingOffset; }
+
+    std::string describe() const { return toStdout ? "stdout" : socketPath; }
+
+    void send(const std::string& bytes) {
+        pending.append(bytes);
+        flush();
+    }
+
+    // Writes as much of the backlog as the sink takes now.
+    void flush() {
+        if (fd < 0 && !socketPath.empty()) redial();
+        while (fd >= 0 && backlog() > 0) {
+            ssize_t n = toStdout ? ::write(fd, pending.data() + pendingOffset, backlog())
+                                 : ::send(fd, pending.data() + pendingOffset, backlog(), kSendFlags);
+            if (n > 0) {
+                pendingOffset += n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            // Peer gone: drop its backlog and dial again later
+            if (!toStdout) ::close(fd);
+            fd = -1;
+            pending.clear();
+            pendingOffset = 0;
+            break;
+        }
+        if (pendingOffset == pending.size()) {
+            pending.clear();
+            pendingOffset = 0;
+        }
+    }
+
+    ~CellSink() { close(); }
+
+private:
+#ifdef MSG_NOSIGNAL
+    static const int kSendFlags = MSG_NOSIGNAL;
+#else
+    static const int kSendFlags = 0;
+#endif
+    using Clock = std::chrono::steady_clock;
+
+    int         fd       = -1;
+    bool        toStdout = false;
+    std::string socketPath;
+    std::string pending;
+    size_t      pendingOffset = 0;
+    Clock::time_point lastDial;
+
+    bool dial() {
+        lastDial = Clock::now();
+        sockaddr_un addr = {};
+        if (socketPath.size() >= sizeof(addr.sun_path)) return false;
+        addr.sun_family = AF_UNIX;
+        socketPath.copy(addr.sun_path, socketPath.size());
+
+        int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s < 0) return false;
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (::connect(s, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+            ::close(s);
+            return false;
+        }
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+        fd    = s;
+        fresh = true;
+        return true;
+    }
+
+    void redial() {
+        if (Clock::now() - lastDial >= std::chrono::seconds(1)) dial();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// AsciiStreamRenderer — streams the ASCII cell grid to a terminal or a
+// remote character / LED display, sending only the cells that changed.
+//
+// The grid comes from AsciiRenderer::buildCells() with the settings of
+// `follow` (cellW, cellH, char set, color mode, area sampling), so the
+// stream shows what the on-screen ASCII layer shows. `columns` x `rows`
+// fixes the grid size; 0 follows the display rect like the on-screen grid.
+//
+// `sent` mirrors what the receiver currently shows. Each frame, cells that
+// differ from it are sent and copied into it. A cell counts as unchanged
+// when its glyph matches and every color channel is within colorThreshold
+// (blanks always match), so sensor noise in per-char mode costs nothing.
+// Short gaps of unchanged cells inside a row are sent rather than
+// re-addressed.
+//
+// Budgets: at most maxFps frames per second, and each frame at most
+// maxBytesPerFrame bytes and what a maxBytesPerSecond token bucket allows
+// (0 = no limit). A frame that runs out of budget stops at a cell; the
+// rest stays different from `sent` and goes out in later frames, starting
+// from the row where this one stopped, so no part of the grid starves.
+// While the sink still has a backlog no new frame is encoded.
+//
+// Formats:
+//   ansi    cursor addressing (CSI row;col H) and 24-bit foreground color
+//           (CSI 38;2;r;g;b m), emitted only when they change. A
+//           (re)connect clears the screen and hides the cursor.
+//   binary  one message per frame, little-endian:
+//             header  "AS" u8 version=1, u8 flags (1 = keyframe: clear to
+//                     blank first), u16 cols, u16 rows, u32 sequence,
+//                     u32 payload bytes
+//             payload runs of  u16 row, u16 col, u16 count,
+//                              count x { u8 glyph, u8 r, u8 g, u8 b }
+//
+// Draws nothing on screen. Keys: i=toggle.
+// ---------------------------------------------------------------------------
+struct AsciiStreamRenderer : Renderer {
+    enum Format { Ansi, Binary };
+
+    Format format = Ansi;
+    const AsciiRenderer* follow = nullptr;
+    int   columns           = 0;
+    int   rows              = 0;
+    float maxFps            = 30.0f;
+    int   maxBytesPerSecond = 0;
+    int   maxBytesPerFrame  = 0;
+    int   colorThreshold    = 8;
+
+    CellSink sink;
+
+    // Last encoded frame, for the HUD.
+    struct Stats {
+        int      bytes        = 0;   // encoded this frame
+        int      cells        = 0;   // sent this frame
+        int      backlogCells = 0;   // changed but over budget
+        uint64_t sequence     = 0;
+    } stats;
+
+    AsciiStreamRenderer() { name = "Stream"; }
+
+    // Opens the sink named by `o`; false if the format is unknown or the
+    // socket cannot be reached (it is retried every second either way).
+    bool open(const StreamOptions& o) {
+        if      (o.format == "ansi")   format = Ansi;
+        else if (o.format == "binary") format = Binary;
+        else return false;
+        columns           = o.columns;
+        rows              = o.rows;
+        maxFps            = o.maxFps;
+        maxBytesPerSecond = o.bytesPerSecond;
+        maxBytesPerFrame  = o.bytesPerFrame;
+        enabled           = true;
+        return o.socketPath.empty() ? sink.openStdout() : sink.openSocket(o.socketPath);
+    }
+
+    void close() {
+        if (sink.connected() && format == Ansi) sink.send("\x1b[0m\x1b[?25h\n");
+        sink.close();
+    }
+
+    ~AsciiStreamRenderer() { close(); }
+
+    void render(const unsigned char* data, int w, int h,
+                float dispX, float dispY, float dispW, float dispH) override {
+        if (!sink.isOpen()) return;
+
+        // Frame budget, then refill the byte budget for the elapsed time
+        auto   now = Clock::now();
+        double dt  = std::chrono::duration<double>(now - lastFrame).count();
+        if (maxFps > 0 && dt < 1.0 / maxFps) return;
+        lastFrame = now;
+        if (maxBytesPerSecond > 0) {
+            tokens = std::min(tokens + maxBytesPerSecond * std::min(dt, 1.0),
+                              maxBytesPerSecond * kBurstSeconds);
+        }
+
+        sink.flush();
+        if (!sink.connected() || sink.backlog() > 0) return;
+
+        size_t budget = SIZE_MAX;
+        if (maxBytesPerFrame  > 0) budget = maxBytesPerFrame;
+        if (maxBytesPerSecond > 0) budget = std::min(budget, (size_t)std::max(tokens, 0.0));
+
+        if (const std::string* bytes = encodeFrame(data, w, h, dispW, dispH, budget)) {
+            sink.send(*bytes);
+            tokens -= bytes->size();
+        }
+    }
+
+    // Everything render() does but pacing and I/O: builds the grid and
+    // encodes one frame against what the receiver shows, within `budget`
+    // bytes. Returns the message, or nullptr if there is nothing to send.
+    const std::string* encodeFrame(const unsigned char* data, int w, int h,
+                                   float dispW, float dispH, size_t budget = SIZE_MAX) {
+        if (follow) {
+            grid.cellW        = follow->cellW;
+            grid.cellH        = follow->cellH;
+            grid.colorMode    = follow->colorMode;
+            grid.charSetIndex = follow->charSetIndex;
+            grid.areaSample   = follow->areaSample;
+        }
+        grid.buildCells(data, w, h, columns > 0 ? columns * grid.cellW : dispW,
+                                    rows    > 0 ? rows    * grid.cellH : dispH);
+
+        bool keyframe = sink.fresh || grid.numCols != sentCols || grid.numRows != sentRows;
+        if (keyframe) resync();
+
+        encode(keyframe, budget);
+        stats.bytes = 0;
+        if (out.size() <= (format == Binary ? kHeaderBytes : 0) && !keyframe) return nullptr;
+        if (format == Binary) finishBinary(keyframe);
+        stats.bytes = (int)out.size();
+        return &out;
+    }
+
+private:
+    using Cell  = AsciiRenderer::Cell;
+    using Clock = std::chrono::steady_clock;
+
+    static const int    kMergeGap     = 2;     // unchanged cells sent inside a run
+    static const size_t kHeaderBytes  = 16;
+    static constexpr double kBurstSeconds = 0.25;
+
+    AsciiRenderer     grid;
+    std::vector<Cell> sent;
+    int    sentCols = 0, sentRows = 0;
+    int    scanRow  = 0;
+    double tokens   = 0;
+    Clock::time_point lastFrame;
+    std::string out;
+
+    // ANSI terminal state after the last byte sent
+    int  cursorRow = -1, cursorCol = -1;
+    Cell color     = { 0, 0, 0, 0 };
+    bool colorSet  = false;
+
+    // The receiver starts from a blank grid; blanks are never sent.
+    void resync() {
+        sentCols = grid.numCols;
+        sentRows = grid.numRows;
+        sent.assign(grid.cells.size(), Cell{ ' ', 0, 0, 0 });
+        sink.fresh = false;
+        scanRow    = 0;
+        cursorRow  = cursorCol = -1;
+        colorSet   = false;
+    }
+
+    bool same(const Cell& a, const Cell& b) const {
+        if (a.glyph != b.glyph) return false;
+        if (a.glyph == ' ')     return true;
+        return std::abs(a.r - b.r) <= colorThreshold && std::abs(a.g - b.g) <= colorThreshold
+            && std::abs(a.b - b.b) <= colorThreshold;
+    }
+
+    // Upper bound of the bytes one more cell adds.
+    size_t cellCost(bool newRun) const {
+        if (format == Binary) return 4 + (newRun ? 6 : 0);
+        return 1 + 19 + (newRun ? 12 : 0);   // glyph, SGR, cursor move
+    }
+
+    void encode(bool keyframe, size_t budget) {
+        out.clear();
+        if (format == Binary) out.resize(kHeaderBytes);
+        else if (keyframe)    out = "\x1b[0m\x1b[2J\x1b[?25l";
+
+        const int cols = sentCols, numRows = sentRows;
+        stats.cells = stats.backlogCells = 0;
+        bool full = false;
+        int  stopRow = -1;
+        for (int k = 0; k < numRows; k++) {
+            int r = (scanRow + k) % numRows;
+            const Cell* now  = &grid.cells[(size_t)r * cols];
+            Cell*       seen = &sent[(size_t)r * cols];
+            int c = 0;
+            while (c < cols) {
+                if (same(now[c], seen[c])) { c++; continue; }
+                // Run [c, end): changed cells joined across short gaps
+                int end = c + 1, gap = 0;
+                for (int i = c + 1; i < cols && gap <= kMergeGap; i++) {
+                    if (same(now[i], seen[i])) { gap++; continue; }
+                    end = i + 1;
+                    gap = 0;
+                }
+                if (full) {
+                    for (int i = c; i < end; i++) stats.backlogCells += !same(now[i], seen[i]);
+                    c = end;
+                    continue;
+                }
+                int sentTo = c;
+                size_t runStart = out.size();
+                for (int i = c; i < end; i++) {
+                    if (out.size() + cellCost(i == c) > budget) {
+                        full    = true;
+                        stopRow = r;
+                        break;
+                    }
+                    if (format == Binary) {
+                        if (i == c) { put16(r); put16(c); put16(0); }
+                        putCell(now[i]);
+                    } else {
+                        putAnsi(r, i, now[i]);
+                    }
+                    stats.cells += !same(now[i], seen[i]);
+                    seen[i] = now[i];
+                    sentTo  = i + 1;
+                }
+                if (format == Binary && sentTo > c) patch16(runStart + 4, sentTo - c);
+                for (int i = sentTo; i < end; i++) stats.backlogCells += !same(now[i], seen[i]);
+                c = end;
+            }
+        }
+        if (stopRow >= 0) scanRow = stopRow;
+    }
+
+    void putAnsi(int r, int c, const Cell& cell) {
+        if (r != cursorRow || c != cursorCol) {
+            out += "\x1b[" + std::to_string(r + 1) + ';' + std::to_string(c + 1) + 'H';
+        }
+        if (!colorSet || cell.r != color.r || cell.g != color.g || cell.b != color.b) {
+            out += "\x1b[38;2;" + std::to_string(cell.r) + ';' + std::to_string(cell.g) + ';'
+                 + std::to_string(cell.b) + 'm';
+            color    = cell;
+            colorSet = true;
+        }
+        out += cell.glyph;
+        cursorRow = r;
+        cursorCol = c + 1 < sentCols ? c + 1 : -1;   // the terminal may wrap
+    }
+
+    void putCell(const Cell& cell) {
+        out += cell.glyph;
+        out += (char)cell.r;
+        out += (char)cell.g;
+        out += (char)cell.b;
+    }
+
+    void put16(int v) {
+        out += (char)(v & 0xFF);
+        out += (char)((v >> 8) & 0xFF);
+    }
+
+    void patch16(size_t at, int v) {
+        out[at]     = (char)(v & 0xFF);
+        out[at + 1] = (char)((v >> 8) & 0xFF);
+    }
+
+    void finishBinary(bool keyframe) {
+        uint32_t payload = (uint32_t)(out.size() - kHeaderBytes);
+        uint32_t seq     = (uint32_t)stats.sequence++;
+        unsigned char* h = (unsigned char*)&out[0];
+        h[0] = 'A'; h[1] = 'S'; h[2] = 1; h[3] = keyframe ? 1 : 0;
+        h[4] = sentCols & 0xFF; h[5] = (sentCols >> 8) & 0xFF;
+        h[6] = sentRows & 0xFF; h[7] = (sentRows >> 8) & 0xFF;
+        for (int i = 0; i < 4; i++) {
+            h[8 + i]  = (seq     >> (8 * i)) & 0xFF;
+            h[12 + i] = (payload >> (8 * i)) & 0xFF;
+        }
+    }
+};
@@ -3,11 +3,21 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include "simd.h"
 
 // ---------------------------------------------------------------------------
 // PixelContext — passed through the effect chain per pixel.
 // Destination is read-only; effects modify the source coordinates.
+// srcFrame is a frame age: 0 = newest input frame, larger = further back.
+// kFeedbackFrame reads the chain's previous output instead.
 // ---------------------------------------------------------------------------
+static const int kFeedbackFrame = -1;
+
 struct PixelContext {
     const int dstRow, dstCol, channel;  // where we're writing (immutable)
     int srcRow, srcCol, srcFrame;        // where we read from (effects modify)
@@ -22,49 +32,374 @@ struct PixelContext {
           time(t), camW(w), camH(h) {}
 };
 
+// ---------------------------------------------------------------------------
+// RowSpan — a run of `count` destination pixels on one row, starting at
+// dstCol0. srcRow/srcCol/srcFrame hold one coordinate per pixel.
+// channel is -1 while the span is shared by all three channels; the chain
+// only splits per channel from the first module that usesChannel().
+//
+// In a sub-pixel pass frac* hold the Q8 fraction (0..255) of each coordinate
+// toward the next row / column / older frame; otherwise they are nullptr.
+// Modules that move coordinates by whole pixels leave them untouched.
+//
+// srcFrame < 0 (kFeedbackFrame) is a sentinel, not an age: modules that
+// move srcFrame leave those entries alone. In a sub-pixel pass such an
+// entry's temporal partner is the live input, read at the entry's position
+// plus inputOffRow / inputOffCol (Q8), so later modules that move the
+// feedback sample move the input sample with it.
+// ---------------------------------------------------------------------------
+static const int kSubpixelBits = 8;
+
+struct RowSpan {
+    int   dstRow, dstCol0, count;
+    int   channel;
+    int*  srcRow;
+    int*  srcCol;
+    int*  srcFrame;
+    float time;
+    int   camW, camH;
+    int*  fracRow   = nullptr;
+    int*  fracCol   = nullptr;
+    int*  fracFrame = nullptr;
+    int*  inputOffRow = nullptr;
+    int*  inputOffCol = nullptr;
+};
+
+// ---------------------------------------------------------------------------
+// StateHash — FNV-1a over the values that shape a module's mapping.
+// EffectChain compares the combined hash frame to frame to spot changes.
+// ---------------------------------------------------------------------------
+struct StateHash {
+    uint64_t value = 1469598103934665603ull;
+
+    void add(const void* data, size_t n) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < n; i++) value = (value ^ p[i]) * 1099511628211ull;
+    }
+
+    template <typename T>
+    StateHash& operator<<(const T& v) { add(&v, sizeof(v)); return *this; }
+};
+
+// ---------------------------------------------------------------------------
+// FixedSine — Q15 sine table indexed by a 32-bit phase (2^32 = one turn).
+// Per-frame shift tables step a phase accumulator through it instead of
+// calling sin() per entry, which matters on FPU-poor ARM boards. scale()
+// returns (int)(amount * sin) with the same truncation toward zero as the
+// float path; results differ from it by at most one pixel.
+//
+// useFixedPointSine() switches the built-in effects between the two.
+// Switch only between frames.
+// ---------------------------------------------------------------------------
+struct FixedSine {
+    static const int kBits = 12;
+
+    static const int16_t* table() {
+        static const std::vector<int16_t> t = [] {
+            std::vector<int16_t> v(1 << kBits);
+            for (int i = 0; i < (1 << kBits); i++) {
+                v[i] = (int16_t)std::lround(32767.0 * std::sin(i * 6.283185307179586 / (1 << kBits)));
+            }
+            return v;
+        }();
+        return t.data();
+    }
+
+    // Radians to phase, wrapped into one turn.
+    static uint32_t phase(double radians) {
+        double turns = radians / 6.283185307179586;
+        return (uint32_t)(int64_t)((turns - std::floor(turns)) * 4294967296.0);
+    }
+
+    // Amounts in Q8 (pixels * 256).
+    static int toQ8(float amount) { return (int)std::lround(amount * 256.0f); }
+
+    static int scale(int amountQ8, uint32_t phase) {
+        int64_t p = (int64_t)amountQ8 * table()[phase >> (32 - kBits)];
+        return (int)(p >= 0 ? p >> 23 : -((-p) >> 23));
+    }
+
+    // amount * sin in Q8, for sub-pixel shifts.
+    static int scaleQ8(int amountQ8, uint32_t phase) {
+        return (int)(((int64_t)amountQ8 * table()[phase >> (32 - kBits)]) >> 15);
+    }
+};
+
+inline bool& fixedPointSineSlot() {
+    static bool on = false;
+    return on;
+}
+inline bool fixedPointSine()              { return fixedPointSineSlot(); }
+inline void useFixedPointSine(bool on)    { fixedPointSineSlot() = on; }
+
+// ---------------------------------------------------------------------------
+// EffectParam — a named, scriptable module parameter. Exactly one of
+// f / i / b points at the field; values travel as float.
+// ---------------------------------------------------------------------------
+struct EffectParam {
+    std::string name;
+    float* f = nullptr;
+    int*   i = nullptr;
+    bool*  b = nullptr;
+
+    EffectParam(const std::string& n, float* p) : name(n), f(p) {}
+    EffectParam(const std::string& n, int* p)   : name(n), i(p) {}
+    EffectParam(const std::string& n, bool* p)  : name(n), b(p) {}
+
+    float get() const { return f ? *f : i ? (float)*i : (*b ? 1.0f : 0.0f); }
+    void  set(float v) const {
+        if (f) *f = v;
+        else if (i) *i = (int)std::lround(v);
+        else *b = v != 0.0f;
+    }
+};
+
 // ---------------------------------------------------------------------------
 // EffectModule — base class for all effect modules.
+// transform() is the per-pixel reference; transformRow() is what the chain
+// actually calls. The default transformRow() loops over transform(), so a
+// module only needs the per-pixel version to work.
 // ---------------------------------------------------------------------------
 struct EffectModule {
+    // What a module's mapping reads besides its input src coordinates.
+    enum Dependency {
+        kUsesTime     = 1 << 0,   // ctx.time
+        kUsesPosition = 1 << 1,   // ctx.dstRow / ctx.dstCol
+        kUsesChannel  = 1 << 2,   // ctx.channel
+    };
+
     bool enabled = false;
     std::string name;
+    std::string type;   // registry key ("wave"), used when saving presets
+
+    // Sub-pixel coordinates, for modules that supportsSubpixel(). While any
+    // active module has it on, the chain tracks RowSpan::frac* and the
+    // gather is bilinear (and temporal across srcFrame), not nearest.
+    bool subpixel = false;
+    virtual bool supportsSubpixel() const { return false; }
+
+    // Processing pixels per parameter pixel, set by EffectChain before
+    // beginFrame(). Modules apply it to every parameter measured in pixels
+    // (amounts, sizes, spatial frequencies) so the look holds when the
+    // processing resolution changes.
+    float pixelScale = 1.0f;
 
     virtual void transform(PixelContext& ctx) = 0;
+
+    // Dependency bits. The default assumes everything, which is always
+    // correct but keeps the module out of the baked remap table.
+    virtual int dependencies() const { return kUsesTime | kUsesPosition | kUsesChannel; }
+
+    bool usesTime()    const { return (dependencies() & kUsesTime)    != 0; }
+    bool usesChannel() const { return (dependencies() & kUsesChannel) != 0; }
+
+    // Feed every parameter that affects the mapping into `h`.
+    virtual void hashState(StateHash& h) const {}
+
+    // Parameters exposed to scripts (offline renders, presets).
+    virtual std::vector<EffectParam> params() { return {}; }
+
+    bool setParam(const std::string& key, float value) {
+        for (auto& p : params()) {
+            if (p.name == key) { p.set(value); return true; }
+        }
+        return false;
+    }
+
+    // Called once per frame on the main thread before any transformRow().
+    // Modules build their per-frame tables here; rows run in parallel.
+    virtual void beginFrame(float time, int camW, int camH) {}
+
+    virtual void transformRow(RowSpan& span) {
+        int ch = std::max(span.channel, 0);
+        for (int i = 0; i < span.count; i++) {
+            PixelContext ctx(span.dstRow, span.dstCol0 + i, ch,
+                             span.srcRow[i], span.srcCol[i], span.srcFrame[i],
+                             span.time, span.camW, span.camH);
+            transform(ctx);
+            span.srcRow[i]   = ctx.srcRow;
+            span.srcCol[i]   = ctx.srcCol;
+            span.srcFrame[i] = ctx.srcFrame;
+        }
+    }
+
     virtual ~EffectModule() = default;
 };
 
 // ---------------------------------------------------------------------------
 // WaveEffect — sine-wave displacement on both axes.
-// Keys: 1 toggles. No param keys assigned here.
+// Keys: 1 toggles. z switches sub-pixel shifts.
 // ---------------------------------------------------------------------------
 struct WaveEffect : EffectModule {
     float speed   = 3.0f;
     float hAmount = 6.0f;
     float vAmount = 10.0f;
 
-    WaveEffect() { name = "Wave"; }
+    // While paused the wave holds its phase at pausedAt and stops
+    // depending on time, which lets the chain bake it.
+    bool  paused   = false;
+    float pausedAt = 0.0f;
+
+    WaveEffect() { name = "Wave"; type = "wave"; }
+
+    void setPaused(bool p, float now) {
+        if (p && !paused) pausedAt = now;
+        paused = p;
+    }
+
+    float waveTime(float t) const { return paused ? pausedAt : t; }
+
+    int dependencies() const override { return paused ? 0 : kUsesTime; }
+
+    void hashState(StateHash& h) const override {
+        h << speed << hAmount << vAmount << paused << pausedAt << fixedPointSine() << subpixel;
+    }
+
+    std::vector<EffectParam> params() override {
+        return { {"speed", &speed}, {"hAmount", &hAmount}, {"vAmount", &vAmount},
+                 {"paused", &paused}, {"pausedAt", &pausedAt}, {"subpixel", &subpixel} };
+    }
+
+    // Sub-pixel shifts remove the stair-stepping of small amounts.
+    bool supportsSubpixel() const override { return true; }
 
     void transform(PixelContext& ctx) override {
-        int hShift = (int)(hAmount * std::sin(ctx.srcRow * 0.03f + ctx.time * speed));
-        int vShift = (int)(vAmount * std::sin(ctx.srcCol * 0.02f + ctx.time * speed * 0.7f));
+        float t = waveTime(ctx.time);
+        int hShift = (int)(hAmount * pixelScale * std::sin(ctx.srcRow * (0.03f / pixelScale) + t * speed));
+        int vShift = (int)(vAmount * pixelScale * std::sin(ctx.srcCol * (0.02f / pixelScale) + t * speed * 0.7f));
         ctx.srcCol = (ctx.srcCol + hShift + ctx.camW) % ctx.camW;
         ctx.srcRow = (ctx.srcRow + vShift + ctx.camH) % ctx.camH;
     }
+
+    // hShift depends only on srcRow and vShift only on srcCol, so the sines
+    // are tabulated once per frame (camH + camW calls instead of per pixel).
+    // With `subpixel`, the Q8 tables hold the same shifts unrounded.
+    std::vector<int> colShiftByRow, rowShiftByCol;
+    std::vector<int> colShiftQ8ByRow, rowShiftQ8ByCol;
+
+    void beginFrame(float time, int camW, int camH) override {
+        time = waveTime(time);
+        colShiftByRow.resize(camH);
+        rowShiftByCol.resize(camW);
+        if (subpixel) beginFrameQ8(time, camW, camH);
+        const float h = hAmount * pixelScale, v = vAmount * pixelScale;
+        const float fh = 0.03f / pixelScale, fv = 0.02f / pixelScale;
+        if (fixedPointSine()) {
+            int      hQ = FixedSine::toQ8(h), vQ = FixedSine::toQ8(v);
+            uint32_t ph = FixedSine::phase((double)time * speed), dh = FixedSine::phase(0.03 / pixelScale);
+            uint32_t pv = FixedSine::phase((double)time * speed * 0.7), dv = FixedSine::phase(0.02 / pixelScale);
+            for (int r = 0; r < camH; r++, ph += dh) colShiftByRow[r] = normalizeShift(FixedSine::scale(hQ, ph), camW);
+            for (int c = 0; c < camW; c++, pv += dv) rowShiftByCol[c] = normalizeShift(FixedSine::scale(vQ, pv), camH);
+            return;
+        }
+        for (int r = 0; r < camH; r++) {
+            int hShift = (int)(h * std::sin(r * fh + time * speed));
+            colShiftByRow[r] = normalizeShift(hShift, camW);
+        }
+        for (int c = 0; c < camW; c++) {
+            int vShift = (int)(v * std::sin(c * fv + time * speed * 0.7f));
+            rowShiftByCol[c] = normalizeShift(vShift, camH);
+        }
+    }
+
+    void transformRow(RowSpan& span) override {
+        if (subpixel && span.fracCol) {
+            transformRowQ8(span);
+            return;
+        }
+        remapKernels().shiftByTables(span.srcRow, span.srcCol, span.count,
+                                     colShiftByRow.data(), rowShiftByCol.data(),
+                                     span.camW, span.camH);
+    }
+
+private:
+    void beginFrameQ8(float time, int camW, int camH) {
+        const int one = 1 << kSubpixelBits;
+        const float h = hAmount * pixelScale, v = vAmount * pixelScale;
+        const float fh = 0.03f / pixelScale, fv = 0.02f / pixelScale;
+        colShiftQ8ByRow.resize(camH);
+        rowShiftQ8ByCol.resize(camW);
+        if (fixedPointSine()) {
+            int      hQ = FixedSine::toQ8(h), vQ = FixedSine::toQ8(v);
+            uint32_t ph = FixedSine::phase((double)time * speed), dh = FixedSine::phase(0.03 / pixelScale);
+            uint32_t pv = FixedSine::phase((double)time * speed * 0.7), dv = FixedSine::phase(0.02 / pixelScale);
+            for (int r = 0; r < camH; r++, ph += dh) colShiftQ8ByRow[r] = normalizeShift(FixedSine::scaleQ8(hQ, ph), camW * one);
+            for (int c = 0; c < camW; c++, pv += dv) rowShiftQ8ByCol[c] = normalizeShift(FixedSine::scaleQ8(vQ, pv), camH * one);
+            return;
+        }
+        for (int r = 0; r < camH; r++) {
+            int hShift = (int)std::lround(h * one * std::sin(r * fh + time * speed));
+            colShiftQ8ByRow[r] = normalizeShift(hShift, camW * one);
+        }
+        for (int c = 0; c < camW; c++) {
+            int vShift = (int)std::lround(v * one * std::sin(c * fv + time * speed * 0.7f));
+            rowShiftQ8ByCol[c] = normalizeShift(vShift, camH * one);
+        }
+    }
+
+    // Same lookups as shiftByTables (by the whole-pixel row / column), on
+    // Q8 positions; wraps stay a conditional subtract.
+    void transformRowQ8(RowSpan& span) {
+        const int wq = span.camW << kSubpixelBits, hq = span.camH << kSubpixelBits;
+        const int mask = (1 << kSubpixelBits) - 1;
+        for (int i = 0; i < span.count; i++) {
+            int r = span.srcRow[i], c = span.srcCol[i];
+            int cq = (c << kSubpixelBits) + span.fracCol[i] + colShiftQ8ByRow[r];
+            int rq = (r << kSubpixelBits) + span.fracRow[i] + rowShiftQ8ByCol[c];
+            cq = cq >= wq ? cq - wq : cq;
+            rq = rq >= hq ? rq - hq : rq;
+            span.srcCol[i]  = cq >> kSubpixelBits;
+            span.srcRow[i]  = rq >> kSubpixelBits;
+            span.fracCol[i] = cq & mask;
+            span.fracRow[i] = rq & mask;
+        }
+    }
 };
 
 // ---------------------------------------------------------------------------
-// SlitscanEffect — each column samples a different frame, creating time trails.
-// Keys: 3 toggles. q/a adjust depth.
+// SlitscanEffect — each row samples an older frame, creating time trails.
+// Ages are clamped to the history actually available (numFrames).
+// Keys: 3 toggles. q/a adjust depth. l blends between frames (sub-pixel).
 // ---------------------------------------------------------------------------
 struct SlitscanEffect : EffectModule {
     int depth;
-    const int numFrames;
+    int numFrames;
 
-    SlitscanEffect(int nFrames) : depth(30), numFrames(nFrames) { name = "Slitscan"; }
+    SlitscanEffect(int nFrames) : depth(30), numFrames(nFrames) { name = "Slitscan"; type = "slitscan"; }
 
+    int  dependencies() const override { return kUsesPosition; }
+    void hashState(StateHash& h) const override { h << depth << numFrames << subpixel; }
+
+    std::vector<EffectParam> params() override { return { {"depth", &depth}, {"subpixel", &subpixel} }; }
+
+    // Sub-pixel ages blend adjacent frames instead of banding per frame.
+    bool supportsSubpixel() const override { return true; }
+
+    // Feedback samples (srcFrame < 0) keep reading the previous output.
     void transform(PixelContext& ctx) override {
+        if (ctx.srcFrame < 0) return;
         int frameOffset = (ctx.dstRow * depth) / ctx.camH;
-        ctx.srcFrame = (ctx.srcFrame - frameOffset + numFrames) % numFrames;
+        ctx.srcFrame = std::min(ctx.srcFrame + frameOffset, numFrames - 1);
+    }
+
+    // Offset depends only on dstRow, so it is computed once per span.
+    void transformRow(RowSpan& span) override {
+        if (subpixel && span.fracFrame) {
+            int offsetQ = ((span.dstRow * depth) << kSubpixelBits) / span.camH;
+            int oldestQ = (numFrames - 1) << kSubpixelBits;
+            for (int i = 0; i < span.count; i++) {
+                if (span.srcFrame[i] < 0) continue;
+                int fq = std::min((span.srcFrame[i] << kSubpixelBits) + span.fracFrame[i] + offsetQ, oldestQ);
+                span.srcFrame[i]  = fq >> kSubpixelBits;
+                span.fracFrame[i] = fq & ((1 << kSubpixelBits) - 1);
+            }
+            return;
+        }
+        int frameOffset = (span.dstRow * depth) / span.camH;
+        int oldest      = numFrames - 1;
+        for (int i = 0; i < span.count; i++) {
+            if (span.srcFrame[i] >= 0) span.srcFrame[i] = std::min(span.srcFrame[i] + frameOffset, oldest);
+        }
     }
 };
 
@@ -76,16 +411,70 @@ struct BlockDisplaceEffect : EffectModule {
     int   blockSize   = 16;
     float blockAmount = 10.0f;
 
-    BlockDisplaceEffect() { name = "BlockDisplace"; }
+    BlockDisplaceEffect() { name = "BlockDisplace"; type = "blockdisplace"; }
+
+    int  dependencies() const override { return kUsesTime; }
+    void hashState(StateHash& h) const override { h << blockSize << blockAmount; }
+
+    std::vector<EffectParam> params() override {
+        return { {"blockSize", &blockSize}, {"blockAmount", &blockAmount} };
+    }
+
+    // Block edge and amount in processing pixels.
+    int   blockPixels() const { return std::max(1, (int)std::lround(blockSize * pixelScale)); }
+    float amountPixels() const { return blockAmount * pixelScale; }
 
     void transform(PixelContext& ctx) override {
-        int blockX = ctx.srcCol / blockSize;
-        int blockY = ctx.srcRow / blockSize;
-        int shiftX = (int)(blockAmount * std::sin(blockY * 0.5f + ctx.time * 2.0f));
-        int shiftY = (int)(blockAmount * 0.5f * std::sin(blockX * 0.3f + ctx.time * 1.5f));
+        int blockX = ctx.srcCol / blockPixels();
+        int blockY = ctx.srcRow / blockPixels();
+        int shiftX = (int)(amountPixels() * std::sin(blockY * 0.5f + ctx.time * 2.0f));
+        int shiftY = (int)(amountPixels() * 0.5f * std::sin(blockX * 0.3f + ctx.time * 1.5f));
         ctx.srcCol = (ctx.srcCol + shiftX + ctx.camW) % ctx.camW;
         ctx.srcRow = (ctx.srcRow + shiftY + ctx.camH) % ctx.camH;
     }
+
+    // shiftX depends only on the block row and shiftY only on the block
+    // column: one sine per block per frame, expanded to per-row/col tables.
+    std::vector<int> colShiftByRow, rowShiftByCol;
+
+    void beginFrame(float time, int camW, int camH) override {
+        const int   size   = blockPixels();
+        const float amount = amountPixels();
+        colShiftByRow.resize(camH);
+        rowShiftByCol.resize(camW);
+        if (fixedPointSine()) {
+            int      xQ = FixedSine::toQ8(amount), yQ = FixedSine::toQ8(amount * 0.5f);
+            uint32_t px = FixedSine::phase((double)time * 2.0), dx = FixedSine::phase(0.5);
+            uint32_t py = FixedSine::phase((double)time * 1.5), dy = FixedSine::phase(0.3);
+            for (int r = 0; r < camH; r += size, px += dx) {
+                std::fill(colShiftByRow.begin() + r, colShiftByRow.begin() + std::min(r + size, camH),
+                          normalizeShift(FixedSine::scale(xQ, px), camW));
+            }
+            for (int c = 0; c < camW; c += size, py += dy) {
+                std::fill(rowShiftByCol.begin() + c, rowShiftByCol.begin() + std::min(c + size, camW),
+                          normalizeShift(FixedSine::scale(yQ, py), camH));
+            }
+            return;
+        }
+        for (int r = 0; r < camH; r += size) {
+            int shiftX = (int)(amount * std::sin((r / size) * 0.5f + time * 2.0f));
+            std::fill(colShiftByRow.begin() + r,
+                      colShiftByRow.begin() + std::min(r + size, camH),
+                      normalizeShift(shiftX, camW));
+        }
+        for (int c = 0; c < camW; c += size) {
+            int shiftY = (int)(amount * 0.5f * std::sin((c / size) * 0.3f + time * 1.5f));
+            std::fill(rowShiftByCol.begin() + c,
+                      rowShiftByCol.begin() + std::min(c + size, camW),
+                      normalizeShift(shiftY, camH));
+        }
+    }
+
+    void transformRow(RowSpan& span) override {
+        remapKernels().shiftByTables(span.srcRow, span.srcCol, span.count,
+                                     colShiftByRow.data(), rowShiftByCol.data(),
+                                     span.camW, span.camH);
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -95,13 +484,182 @@ struct BlockDisplaceEffect : EffectModule {
 struct RgbSplitEffect : EffectModule {
     int shiftAmount = 7;
 
-    RgbSplitEffect() { name = "RgbSplit"; }
+    RgbSplitEffect() { name = "RgbSplit"; type = "rgbsplit"; }
+
+    // Shift in processing pixels.
+    int shiftPixels() const { return (int)std::lround(shiftAmount * pixelScale); }
 
     void transform(PixelContext& ctx) override {
         if (ctx.channel == 0) {
-            ctx.srcCol = (ctx.srcCol - shiftAmount + ctx.camW) % ctx.camW;
+            ctx.srcCol = (ctx.srcCol - shiftPixels() + ctx.camW) % ctx.camW;
         } else if (ctx.channel == 2) {
-            ctx.srcCol = (ctx.srcCol + shiftAmount) % ctx.camW;
+            ctx.srcCol = (ctx.srcCol + shiftPixels()) % ctx.camW;
         }
     }
+
+    int  dependencies() const override { return kUsesChannel; }
+    void hashState(StateHash& h) const override { h << shiftAmount; }
+
+    std::vector<EffectParam> params() override { return { {"shiftAmount", &shiftAmount} }; }
+
+    void transformRow(RowSpan& span) override {
+        int shift = 0;
+        if (span.channel == 0)      shift = -shiftPixels();
+        else if (span.channel == 2) shift = shiftPixels();
+        if (shift == 0) return;
+        remapKernels().addWrap(span.srcCol, span.count,
+                               normalizeShift(shift, span.camW), span.camW);
+    }
 };
+
+// ---------------------------------------------------------------------------
+// FeedbackEffect — samples the chain's previous output (srcFrame =
+// kFeedbackFrame), zoomed about the centre: decay trails at zoom 1,
+// video-feedback tunnels above it. `mix` is the share of the previous
+// output in each frame, so a trail fades by that factor per frame.
+//
+//   pixel mode      a 4x4 ordered-dither pattern, shifted every frame,
+//                   sends `mix` of the pixels to the feedback and leaves
+//                   the rest on the input; the blend averages out over
+//                   a few frames
+//   subpixel mode   every pixel is a true blend through the chain's
+//                   temporal lerp: the feedback read at the zoomed
+//                   position, the newest input where pixel mode reads it
+//
+// Slitscan after it leaves feedback samples alone.
+// Keys: 7 toggles. 8/9 adjust mix.
+// ---------------------------------------------------------------------------
+struct FeedbackEffect : EffectModule {
+    float mix  = 0.85f;
+    float zoom = 1.0f;    // > 1 zooms in, so trails stream outward
+
+    FeedbackEffect() { name = "Feedback"; type = "feedback"; }
+
+    // Time: the dither pattern moves every frame.
+    int  dependencies() const override { return kUsesTime | kUsesPosition; }
+    void hashState(StateHash& h) const override { h << mix << zoom << subpixel; }
+
+    std::vector<EffectParam> params() override {
+        return { {"mix", &mix}, {"zoom", &zoom}, {"subpixel", &subpixel} };
+    }
+
+    bool supportsSubpixel() const override { return true; }
+
+    void transform(PixelContext& ctx) override {
+        if (!feedbackAt(ctx.dstRow, ctx.dstCol)) return;
+        ctx.srcRow   = zoomRow[ctx.srcRow];
+        ctx.srcCol   = zoomCol[ctx.srcCol];
+        ctx.srcFrame = kFeedbackFrame;
+    }
+
+    void beginFrame(float time, int camW, int camH) override {
+        frameIndex++;
+        mixCount = (int)std::lround(std::min(std::max(mix, 0.0f), 1.0f) * 16);
+        mixQ8    = (int)std::lround(std::min(std::max(mix, 0.0f), 1.0f) * (1 << kSubpixelBits));
+        buildZoom(zoomRow, zoomRowQ8, camH);
+        buildZoom(zoomCol, zoomColQ8, camW);
+    }
+
+    void transformRow(RowSpan& span) override {
+        if (subpixel && span.fracFrame) {
+            if (mixQ8 == 0) return;
+            int toInput = std::min((1 << kSubpixelBits) - mixQ8, (1 << kSubpixelBits) - 1);
+            const int mask = (1 << kSubpixelBits) - 1;
+            for (int i = 0; i < span.count; i++) {
+                int rq = zoomRowQ8[span.srcRow[i]], cq = zoomColQ8[span.srcCol[i]];
+                span.inputOffRow[i] = (span.srcRow[i] << kSubpixelBits) + span.fracRow[i] - rq;
+                span.inputOffCol[i] = (span.srcCol[i] << kSubpixelBits) + span.fracCol[i] - cq;
+                span.srcRow[i]    = rq >> kSubpixelBits;
+                span.srcCol[i]    = cq >> kSubpixelBits;
+                span.fracRow[i]   = rq & mask;
+                span.fracCol[i]   = cq & mask;
+                span.srcFrame[i]  = kFeedbackFrame;
+                span.fracFrame[i] = toInput;
+            }
+            return;
+        }
+        for (int i = 0; i < span.count; i++) {
+            if (!feedbackAt(span.dstRow, span.dstCol0 + i)) continue;
+            span.srcRow[i]   = zoomRow[span.srcRow[i]];
+            span.srcCol[i]   = zoomCol[span.srcCol[i]];
+            span.srcFrame[i] = kFeedbackFrame;
+            if (span.fracFrame) span.fracFrame[i] = 0;
+        }
+    }
+
+private:
+    int frameIndex = 0, mixCount = 0, mixQ8 = 0;
+
+    // Source coordinate per coordinate on each axis, whole and Q8.
+    std::vector<int> zoomRow, zoomCol, zoomRowQ8, zoomColQ8;
+
+    bool feedbackAt(int r, int c) const {
+        static const uint8_t bayer[4][4] = {
+            {  0,  8,  2, 10 }, { 12,  4, 14,  6 }, {  3, 11,  1,  9 }, { 15,  7, 13,  5 },
+        };
+        return bayer[(r + (frameIndex >> 2)) & 3][(c + frameIndex) & 3] < mixCount;
+    }
+
+    void buildZoom(std::vector<int>& whole, std::vector<int>& q8, int size) const {
+        const int one = 1 << kSubpixelBits;
+        float centre = (size - 1) * 0.5f;
+        float scale  = zoom > 0.0f ? 1.0f / zoom : 1.0f;
+        whole.resize(size);
+        q8.resize(size);
+        for (int p = 0; p < size; p++) {
+            float src = centre + (p - centre) * scale;
+            whole[p]  = normalizeShift((int)std::lround(src), size);
+            q8[p]     = normalizeShift((int)std::lround(src * one), size * one);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// EffectRegistry — module factories by type name (case-insensitive), so
+// chains can be built from presets and command lines. The built-ins are
+// registered on first use; add() registers more. create() returns nullptr
+// for unknown types and stamps the module's `type` with the key.
+// Slitscan starts with numFrames = 1; the caller sets it to the history depth.
+// ---------------------------------------------------------------------------
+struct EffectRegistry {
+    using Factory = std::function<EffectModule*()>;
+
+    static EffectRegistry& get() {
+        static EffectRegistry registry;
+        return registry;
+    }
+
+    void add(const std::string& type, Factory factory) { factories[lower(type)] = std::move(factory); }
+
+    EffectModule* create(const std::string& type) const {
+        auto it = factories.find(lower(type));
+        if (it == factories.end()) return nullptr;
+        EffectModule* m = it->second();
+        if (m) m->type = it->first;
+        return m;
+    }
+
+    std::vector<std::string> types() const {
+        std::vector<std::string> t;
+        for (auto& f : factories) t.push_back(f.first);
+        return t;
+    }
+
+private:
+    std::map<std::string, Factory> factories;
+
+    EffectRegistry() {
+        add("wave",          [] { return new WaveEffect(); });
+        add("slitscan",      [] { return new SlitscanEffect(1); });
+        add("blockdisplace", [] { return new BlockDisplaceEffect(); });
+        add("rgbsplit",      [] { return new RgbSplitEffect(); });
+        add("feedback",      [] { return new FeedbackEffect(); });
+    }
+
+    static std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
+};
+
+inline EffectModule* makeEffect(const std::string& type) { return EffectRegistry::get().create(type); }
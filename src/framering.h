@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ingest.h"
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// FrameRing — history of input frames in one contiguous, 64-byte aligned
+// arena. Frames are addressed by age: 0 is the newest, depth()-1 the oldest.
+// Effects read them through byAge(), the pointer table the remap kernels
+// index directly.
+//
+// Writing a frame: fill nextSlot() (the oldest slot) and call commit().
+// pushPixels() does both straight from an ofPixels, converting and scaling
+// into the slot through a FrameIngest so there is no intermediate copy.
+//
+// A producer on another thread can fill frames without touching the
+// history: allocate() lays out `spares` extra slots in the same arena, and
+// adopt() swaps a filled spare in as the newest frame, handing back the
+// oldest frame's slot as the next spare. No pixels are copied.
+//
+// allocate() is a no-op when nothing changed; a new size or depth re-lays
+// out the arena, empties the history and bumps layout(), after which spare
+// slots handed out before are invalid. The arena is kept whenever it is
+// large enough (and not over twice the size needed) and only one slot is
+// cleared: until filledDepth() reaches depth(), ages past the oldest frame
+// written read that frame instead of stale slots. allocatePacked() holds frames in
+// some other layout of bytesPerFrame each.
+// ---------------------------------------------------------------------------
+struct FrameRing {
+    static const size_t kAlign = 64;
+
+    void allocate(int w, int h, int depth, int spares = 0) {
+        allocatePacked(w, h, depth, (size_t)w * h * 3, spares);
+    }
+
+    void allocatePacked(int w, int h, int depth, size_t bytesPerFrame, int spares = 0) {
+        depth  = std::max(depth, 1);
+        spares = std::max(spares, 0);
+        if (w == width && h == height && depth == (int)slots.size()
+                       && bytesPerFrame == frameBytes && spares == (int)spareSlots.size()) return;
+
+        width      = w;
+        height     = h;
+        frameBytes = bytesPerFrame;
+        slotBytes  = (frameBytes + kAlign - 1) / kAlign * kAlign;
+
+        size_t needed = slotBytes * (depth + spares) + kAlign;
+        if (needed > arenaSize || needed < arenaSize / 2) {
+            arena.reset();
+            arena.reset(new unsigned char[needed]);
+            arenaSize = needed;
+        }
+        unsigned char* base = arena.get();
+        base += (kAlign - (uintptr_t)base % kAlign) % kAlign;
+
+        slots.resize(depth);
+        for (int i = 0; i < depth; i++) slots[i] = base + slotBytes * i;
+        spareSlots.resize(spares);
+        for (int i = 0; i < spares; i++) spareSlots[i] = base + slotBytes * (depth + i);
+        ages.resize(depth);
+        newest = 0;
+        filled = 0;
+        std::memset(slots[0], 0, frameBytes);   // what every age reads until the first commit()
+        updateAges();
+        layoutId++;
+    }
+
+    void release() {
+        arena.reset();
+        arenaSize = 0;
+        filled    = 0;
+        slots.clear();
+        spareSlots.clear();
+        ages.clear();
+        width = height = 0;
+        frameBytes = slotBytes = 0;
+        layoutId++;
+    }
+
+    int    depth()     const { return (int)slots.size(); }
+    size_t bytes()     const { return frameBytes; }
+    size_t arenaBytes() const { return arenaSize; }
+    int    filledDepth() const { return filled; }   // frames written since allocate()
+    int    getWidth()  const { return width; }
+    int    getHeight() const { return height; }
+
+    // Slot that the next frame will occupy (currently the oldest frame).
+    unsigned char* nextSlot() { return slots[(newest + 1) % depth()]; }
+
+    void commit() {
+        newest = (newest + 1) % depth();
+        filled = std::min(filled + 1, depth());
+        updateAges();
+    }
+
+    // The spare slots as laid out by the last allocate(). Hand them out
+    // once per layout(): adopt() moves them into the history.
+    const std::vector<unsigned char*>& spares() const { return spareSlots; }
+    unsigned layout() const { return layoutId; }
+
+    // Makes `frame` (a filled slot of this arena from spares() or an
+    // earlier adopt()) the newest frame and returns the oldest frame's slot
+    // through it, free to fill next.
+    void adopt(unsigned char*& frame) {
+        std::swap(slots[(newest + 1) % depth()], frame);
+        commit();
+    }
+
+    // Data pointers indexed by age, valid until the next commit().
+    const unsigned char* const* byAge() const { return ages.data(); }
+
+    // Writes px into nextSlot() and commits it. px may be any size and
+    // pixel format; see FrameIngest.
+    void pushPixels(const ofPixels& px) {
+        ingest.convert(px, nextSlot(), width, height);
+        commit();
+    }
+
+private:
+    std::unique_ptr<unsigned char[]> arena;
+    size_t                      arenaSize = 0;
+    std::vector<unsigned char*> slots;
+    std::vector<unsigned char*> spareSlots;
+    std::vector<unsigned char*> ages;
+    FrameIngest ingest;
+
+    int    width = 0, height = 0;
+    size_t frameBytes = 0, slotBytes = 0;
+    int    newest = 0, filled = 0;
+    unsigned layoutId = 0;
+
+    void updateAges() {
+        int n = depth(), last = std::max(filled, 1) - 1;
+        for (int a = 0; a < n; a++) ages[a] = slots[(newest - std::min(a, last) + n) % n];
+    }
+};
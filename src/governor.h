@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// ResolutionGovernor — picks the processing resolution that holds a target
+// frame rate.
+//
+// The caller feeds one cost per frame (ms of remap + render work, see
+// ofApp::draw()) and applies size() whenever addFrame() returns true.
+// levels[] are scales of the design size, largest first. Every `window`
+// frames the governor looks at the 75th percentile cost:
+//
+//   over  kHighWater of the frame budget   drop straight to the largest
+//                                          level whose cost, assumed to
+//                                          scale with pixel count, fits
+//                                          kTargetLoad of the budget
+//   under kLowWater                        go up one level if its predicted
+//                                          cost also fits kTargetLoad
+//
+// The gap between the marks, and the `settle` frames ignored after each
+// change (caches, history refill), keep it from oscillating.
+// ---------------------------------------------------------------------------
+struct ResolutionGovernor {
+    bool  enabled   = false;
+    float targetFps = 30.0f;
+    std::vector<float> levels = { 1.0f, 0.85f, 0.7f, 0.6f, 0.5f, 0.4f, 0.3f, 0.25f };
+    int   level  = 0;
+    int   window = 30;
+    int   settle = 30;
+
+    float scale() const { return levels[level]; }
+
+    // Processing size for a design size at the current level: aspect kept,
+    // width a multiple of 8 and both sides at least 16.
+    void size(int designW, int designH, int& w, int& h) const {
+        w = std::max(16, (int)(designW * scale()) / 8 * 8);
+        h = std::max(16, (int)((float)w * designH / designW + 0.5f));
+    }
+
+    void reset() {
+        costs.clear();
+        skip = settle;
+    }
+
+    // Returns true when `level` changed.
+    bool addFrame(double costMs) {
+        if (!enabled) return false;
+        if (skip > 0) {
+            skip--;
+            return false;
+        }
+        costs.push_back(costMs);
+        if ((int)costs.size() < window) return false;
+
+        std::nth_element(costs.begin(), costs.begin() + costs.size() * 3 / 4, costs.end());
+        double cost   = costs[costs.size() * 3 / 4];
+        double budget = 1000.0 / targetFps;
+        costs.clear();
+
+        int next = level;
+        if (cost > budget * kHighWater) {
+            while (next + 1 < (int)levels.size() && predict(cost, next) > budget * kTargetLoad) next++;
+        } else if (cost < budget * kLowWater && level > 0
+                   && predict(cost, level - 1) < budget * kTargetLoad) {
+            next = level - 1;
+        }
+        if (next == level) return false;
+        level = next;
+        skip  = settle;
+        return true;
+    }
+
+private:
+    static constexpr double kHighWater  = 0.9;
+    static constexpr double kLowWater   = 0.5;
+    static constexpr double kTargetLoad = 0.7;
+
+    std::vector<double> costs;
+    int skip = 0;
+
+    // Cost at level l, from the current one, by pixel count.
+    double predict(double cost, int l) const {
+        double r = levels[l] / scale();
+        return cost * r * r;
+    }
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "framering.h"
+#include "profiler.h"
+#include <string>
+
+// ---------------------------------------------------------------------------
+// FrameHistory — input history sized by a memory budget instead of a frame
+// count. Two tiers, both addressed by age:
+//
+//   recent  ages [0, recentDepth())          full-res RGB FrameRing
+//   older   ages [recentDepth(), depth())    compact copies, one per frame
+//
+// When a frame is about to fall out of the recent ring it is encoded into
+// the older tier. Compact formats (bytes per pixel):
+//
+//   Full      3.0   no older tier; the whole budget goes to full frames
+//   HalfRes   0.75  2x2 box-averaged RGB
+//   YCbCr420  1.5   full-res luma, 2x2 subsampled chroma (BT.601 full range)
+//
+// Older frames are decoded per sample by sample(), so the remap gather only
+// touches the pixels it actually reads.
+// ---------------------------------------------------------------------------
+struct FrameHistory {
+    enum Format { Full, HalfRes, YCbCr420, kNumFormats };
+
+    static const char* formatName(Format f) {
+        static const char* names[] = { "full", "half-res", "ycbcr420" };
+        return names[f];
+    }
+
+    // Splits budgetMB between up to `recentFrames` full frames and as many
+    // compact frames as fit in the rest. Empties the history if the layout
+    // changes, without reallocating or clearing memory that is large enough.
+    // `spareFrames` full frames are laid out for a producer to fill and
+    // adoptFrame() (see FrameRing); they come out of the budget too.
+    void configure(int w, int h, float budgetMB, int recentFrames, Format fmt, int spareFrames = 0) {
+        width  = w;
+        height = h;
+        format = fmt;
+        halfW  = (w + 1) / 2;
+        halfH  = (h + 1) / 2;
+
+        size_t fullBytes  = (size_t)w * h * 3;
+        size_t spareBytes = fullBytes * spareFrames;
+        size_t budget     = std::max((size_t)(std::max(budgetMB, 1.0f) * 1024 * 1024),
+                                     spareBytes + fullBytes) - spareBytes;
+        int    maxFull   = std::max(1, (int)(budget / fullBytes));
+        int    numFull   = fmt == Full ? maxFull : std::min(recentFrames, maxFull);
+        recent.allocate(w, h, numFull, spareFrames);
+
+        size_t left = budget - std::min(budget, fullBytes * numFull);
+        size_t packedBytes = compactBytes();
+        int    numOlder    = packedBytes ? (int)(left / packedBytes) : 0;
+        if (numOlder > 0) {
+            older.allocatePacked(w, h, numOlder, packedBytes);
+        } else {
+            older.release();
+        }
+    }
+
+    int getWidth()    const { return width; }
+    int getHeight()   const { return height; }
+    int depth()       const { return recent.depth() + older.depth(); }
+    int recentDepth() const { return recent.depth(); }
+    int olderDepth()  const { return older.depth(); }
+
+    size_t allocatedBytes() const { return recent.arenaBytes() + older.arenaBytes(); }
+
+    // Ages [0, recentDepth()) as RGB frame pointers.
+    const unsigned char* const* byAge() const { return recent.byAge(); }
+
+    // Times pushPixels() / pushFrame() as "ingest/encode" and "ingest/ring".
+    void attachProfiler(Profiler* p) {
+        profiler = p;
+        if (!p) return;
+        encodeStage = p->stage("ingest/encode");
+        ringStage   = p->stage("ingest/ring");
+    }
+
+    void pushPixels(const ofPixels& px) {
+        retireOldestRecent();
+        ProfileScope scope(profiler, ringStage);
+        recent.pushPixels(px);
+    }
+
+    // Same, from a frame already converted to w x h RGB.
+    void pushFrame(const unsigned char* rgb) {
+        retireOldestRecent();
+        ProfileScope scope(profiler, ringStage);
+        std::memcpy(recent.nextSlot(), rgb, recent.bytes());
+        recent.commit();
+    }
+
+    // Same, without the copy: `frame` is a filled spare (see configure())
+    // and comes back as the slot to fill next.
+    void adoptFrame(unsigned char*& frame) {
+        retireOldestRecent();
+        ProfileScope scope(profiler, ringStage);
+        recent.adopt(frame);
+    }
+
+    const std::vector<unsigned char*>& spares() const { return recent.spares(); }
+    unsigned layout() const { return recent.layout(); }
+
+    // One channel of one pixel from an older frame (age >= recentDepth()).
+    unsigned char sample(int age, int r, int c, int ch) const {
+        unsigned char rgb[3];
+        sample(age, r, c, rgb);
+        return rgb[ch];
+    }
+
+    void sample(int age, int r, int c, unsigned char* rgb) const {
+        if (older.filledDepth() == 0) {
+            // Nothing retired since the last re-layout: repeat the oldest full frame
+            const unsigned char* s = recent.byAge()[recent.depth() - 1] + ((size_t)r * width + c) * 3;
+            rgb[0] = s[0]; rgb[1] = s[1]; rgb[2] = s[2];
+            return;
+        }
+        const unsigned char* p = older.byAge()[std::min(age - recent.depth(), older.depth() - 1)];
+        if (format == HalfRes) {
+            const unsigned char* s = p + ((size_t)(r >> 1) * halfW + (c >> 1)) * 3;
+            rgb[0] = s[0]; rgb[1] = s[1]; rgb[2] = s[2];
+            return;
+        }
+        int y  = p[(size_t)r * width + c];
+        size_t ci = (size_t)(r >> 1) * halfW + (c >> 1);
+        const unsigned char* cb = p + (size_t)width * height;
+        int u = cb[ci] - 128;
+        int v = cb[(size_t)halfW * halfH + ci] - 128;
+        rgb[0] = clampByte(y + ((359 * v) >> 8));
+        rgb[1] = clampByte(y - ((88 * u + 183 * v) >> 8));
+        rgb[2] = clampByte(y + ((454 * u) >> 8));
+    }
+
+private:
+    FrameRing recent, older;
+    Format    format = Full;
+    int       width = 0, height = 0, halfW = 0, halfH = 0;
+
+    Profiler* profiler = nullptr;
+    int       encodeStage = -1, ringStage = -1;
+
+    // Moves the frame about to be overwritten in `recent` into `older`, once
+    // the ring has wrapped since the last re-layout.
+    void retireOldestRecent() {
+        if (older.depth() == 0 || recent.filledDepth() < recent.depth()) return;
+        ProfileScope scope(profiler, encodeStage);
+        encode(recent.byAge()[recent.depth() - 1], older.nextSlot());
+        older.commit();
+    }
+
+    static unsigned char clampByte(int v) { return (unsigned char)std::min(std::max(v, 0), 255); }
+
+    size_t compactBytes() const {
+        switch (format) {
+            case HalfRes:  return (size_t)halfW * halfH * 3;
+            case YCbCr420: return (size_t)width * height + (size_t)halfW * halfH * 2;
+            default:       return 0;
+        }
+    }
+
+    // Averages the (up to) 2x2 block of RGB pixels whose top-left is (r, c).
+    void average2x2(const unsigned char* rgb, int r, int c, int* sum) const {
+        int r1 = std::min(r + 1, height - 1), c1 = std::min(c + 1, width - 1);
+        const unsigned char* p[4] = {
+            rgb + ((size_t)r  * width + c)  * 3, rgb + ((size_t)r  * width + c1) * 3,
+            rgb + ((size_t)r1 * width + c)  * 3, rgb + ((size_t)r1 * width + c1) * 3,
+        };
+        for (int ch = 0; ch < 3; ch++) {
+            sum[ch] = (p[0][ch] + p[1][ch] + p[2][ch] + p[3][ch] + 2) >> 2;
+        }
+    }
+
+    void encode(const unsigned char* rgb, unsigned char* dst) const {
+        if (format == HalfRes) {
+            for (int r = 0; r < halfH; r++) {
+                for (int c = 0; c < halfW; c++) {
+                    int avg[3];
+                    average2x2(rgb, r * 2, c * 2, avg);
+                    unsigned char* d = dst + ((size_t)r * halfW + c) * 3;
+                    d[0] = avg[0]; d[1] = avg[1]; d[2] = avg[2];
+                }
+            }
+            return;
+        }
+
+        // YCbCr 4:2:0: luma plane, then Cb and Cr planes at half resolution
+        size_t n = (size_t)width * height;
+        for (size_t i = 0; i < n; i++) {
+            const unsigned char* s = rgb + i * 3;
+            dst[i] = (77 * s[0] + 150 * s[1] + 29 * s[2]) >> 8;
+        }
+        unsigned char* cb = dst + n;
+        unsigned char* cr = cb + (size_t)halfW * halfH;
+        for (int r = 0; r < halfH; r++) {
+            for (int c = 0; c < halfW; c++) {
+                int avg[3];
+                average2x2(rgb, r * 2, c * 2, avg);
+                size_t ci = (size_t)r * halfW + c;
+                cb[ci] = clampByte(((-43 * avg[0] - 85 * avg[1] + 128 * avg[2]) >> 8) + 128);
+                cr[ci] = clampByte(((128 * avg[0] - 107 * avg[1] - 21 * avg[2]) >> 8) + 128);
+            }
+        }
+    }
+};
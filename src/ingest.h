@@ -0,0 +1,203 @@
+#pragma once
+
+#include "ofMain.h"
+#include "simd.h"
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// IngestKernels — 4-byte to 3-byte pixel packing for decoded frames.
+//
+//   rgbaToRgb   drops alpha
+//   bgraToRgb   drops alpha and swaps R/B
+//
+// SSSE3 (pshufb) on x86, NEON (vld4/vst3) on ARM, scalar elsewhere; all
+// variants are byte-identical.
+// ---------------------------------------------------------------------------
+struct IngestKernels {
+    const char* name;
+    void (*rgbaToRgb)(const unsigned char* src, unsigned char* dst, int n);
+    void (*bgraToRgb)(const unsigned char* src, unsigned char* dst, int n);
+};
+
+// --- scalar reference ------------------------------------------------------
+
+inline void rgbaToRgbScalar(const unsigned char* src, unsigned char* dst, int n) {
+    for (int i = 0; i < n; i++, src += 4, dst += 3) {
+        dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+    }
+}
+
+inline void bgraToRgbScalar(const unsigned char* src, unsigned char* dst, int n) {
+    for (int i = 0; i < n; i++, src += 4, dst += 3) {
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+    }
+}
+
+// --- SSSE3 -----------------------------------------------------------------
+
+#if defined(OFXFILTERS_SSSE3)
+// 16 pixels per step: four shuffles pack 12 bytes each, three stores.
+OFXFILTERS_TARGET_SSSE3
+inline void pack4To3Ssse3(const unsigned char* src, unsigned char* dst, int n, __m128i mask,
+                          void (*tail)(const unsigned char*, unsigned char*, int)) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dst += 48) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src +  0)), mask);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), mask);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 32)), mask);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 48)), mask);
+        _mm_storeu_si128((__m128i*)(dst +  0), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128((__m128i*)(dst + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128((__m128i*)(dst + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+    tail(src, dst, n - i);
+}
+
+OFXFILTERS_TARGET_SSSE3
+inline void rgbaToRgbSsse3(const unsigned char* src, unsigned char* dst, int n) {
+    pack4To3Ssse3(src, dst, n, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                             -1, -1, -1, -1), rgbaToRgbScalar);
+}
+
+OFXFILTERS_TARGET_SSSE3
+inline void bgraToRgbSsse3(const unsigned char* src, unsigned char* dst, int n) {
+    pack4To3Ssse3(src, dst, n, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                             -1, -1, -1, -1), bgraToRgbScalar);
+}
+#endif
+
+// --- NEON ------------------------------------------------------------------
+
+#if defined(OFXFILTERS_NEON)
+inline void rgbaToRgbNeon(const unsigned char* src, unsigned char* dst, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dst += 48) {
+        uint8x16x4_t in = vld4q_u8(src);
+        uint8x16x3_t out = { { in.val[0], in.val[1], in.val[2] } };
+        vst3q_u8(dst, out);
+    }
+    rgbaToRgbScalar(src, dst, n - i);
+}
+
+inline void bgraToRgbNeon(const unsigned char* src, unsigned char* dst, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dst += 48) {
+        uint8x16x4_t in = vld4q_u8(src);
+        uint8x16x3_t out = { { in.val[2], in.val[1], in.val[0] } };
+        vst3q_u8(dst, out);
+    }
+    bgraToRgbScalar(src, dst, n - i);
+}
+#endif
+
+// --- dispatch --------------------------------------------------------------
+
+inline const IngestKernels& scalarIngestKernels() {
+    static const IngestKernels k = { "scalar", rgbaToRgbScalar, bgraToRgbScalar };
+    return k;
+}
+
+inline const IngestKernels& bestIngestKernels() {
+#if defined(OFXFILTERS_SSSE3)
+    static const IngestKernels ssse3 = { "ssse3", rgbaToRgbSsse3, bgraToRgbSsse3 };
+    if (__builtin_cpu_supports("ssse3")) return ssse3;
+#elif defined(OFXFILTERS_NEON)
+    static const IngestKernels neon = { "neon", rgbaToRgbNeon, bgraToRgbNeon };
+    return neon;
+#endif
+    return scalarIngestKernels();
+}
+
+// ---------------------------------------------------------------------------
+// FrameIngest — converts a decoded frame of any size into a w x h RGB buffer.
+//
+//   RGB / BGR / RGBA / BGRA   handled directly from the source pixels
+//   other formats             via ofPixels::setImageType into a reused scratch
+//
+// Same size: a row copy or one packing kernel call per row. Scaled: nearest
+// neighbour at pixel centres, reading only the source pixels that are kept,
+// so a 4K RGBA frame is never converted as a whole. An integer ratio walks
+// the source row with a fixed stride; other ratios use row/column index
+// tables rebuilt only when the sizes change.
+// ---------------------------------------------------------------------------
+struct FrameIngest {
+    const IngestKernels* kernels = &bestIngestKernels();
+
+    void convert(const ofPixels& px, unsigned char* dst, int w, int h) {
+        int  bpp;
+        bool swapRB;
+        switch (px.getPixelFormat()) {
+            case OF_PIXELS_RGB:  bpp = 3; swapRB = false; break;
+            case OF_PIXELS_BGR:  bpp = 3; swapRB = true;  break;
+            case OF_PIXELS_RGBA: bpp = 4; swapRB = false; break;
+            case OF_PIXELS_BGRA: bpp = 4; swapRB = true;  break;
+            default:
+                if (&px == &scratch) return;   // setImageType could not make RGB
+                scratch = px;
+                scratch.setImageType(OF_IMAGE_COLOR);
+                convert(scratch, dst, w, h);
+                return;
+        }
+
+        int srcW = (int)px.getWidth(), srcH = (int)px.getHeight();
+        size_t stride = px.getBytesStride();
+        const unsigned char* src = px.getData();
+        size_t rowBytes = (size_t)w * 3;
+
+        if (srcW == w && srcH == h) {
+            for (int y = 0; y < h; y++) {
+                const unsigned char* s = src + y * stride;
+                unsigned char*       d = dst + y * rowBytes;
+                if (bpp == 4) (swapRB ? kernels->bgraToRgb : kernels->rgbaToRgb)(s, d, w);
+                else if (!swapRB) std::memcpy(d, s, rowBytes);
+                else              bgrToRgb(s, d, w);
+            }
+            return;
+        }
+
+        buildTables(srcW, srcH, w, h, bpp);
+        int r = swapRB ? 2 : 0, b = swapRB ? 0 : 2;
+        bool fixedRatio = srcW % w == 0;
+        int  step = srcW / w * bpp;
+        for (int y = 0; y < h; y++) {
+            const unsigned char* s = src + srcRow[y] * stride;
+            unsigned char*       d = dst + y * rowBytes;
+            if (fixedRatio) {
+                const unsigned char* p = s + srcCol[0];
+                for (int x = 0; x < w; x++, p += step, d += 3) {
+                    d[0] = p[r]; d[1] = p[1]; d[2] = p[b];
+                }
+            } else {
+                for (int x = 0; x < w; x++, d += 3) {
+                    const unsigned char* p = s + srcCol[x];
+                    d[0] = p[r]; d[1] = p[1]; d[2] = p[b];
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<int> srcRow;    // source row per output row
+    std::vector<int> srcCol;    // source byte offset per output column
+    int tableKey[5] = { -1, -1, -1, -1, -1 };
+    ofPixels scratch;
+
+    void buildTables(int srcW, int srcH, int w, int h, int bpp) {
+        int key[5] = { srcW, srcH, w, h, bpp };
+        if (std::equal(key, key + 5, tableKey)) return;
+        std::copy(key, key + 5, tableKey);
+        srcRow.resize(h);
+        srcCol.resize(w);
+        for (int y = 0; y < h; y++) srcRow[y] = (int)(((int64_t)y * 2 + 1) * srcH / (2 * h));
+        for (int x = 0; x < w; x++) srcCol[x] = (int)(((int64_t)x * 2 + 1) * srcW / (2 * w)) * bpp;
+    }
+
+    static void bgrToRgb(const unsigned char* s, unsigned char* d, int n) {
+        for (int i = 0; i < n; i++, s += 3, d += 3) {
+            d[0] = s[2]; d[1] = s[1]; d[2] = s[0];
+        }
+    }
+};
@@ -1,8 +1,41 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "offline.h"
+#include "bench.h"
+#include "verify.h"
+#include "recording.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+
+	// Headless benchmark (see bench.h)
+	BenchOptions bench;
+	if (parseBenchArgs(argc, argv, bench)) {
+		return runBench(bench);
+	}
+
+	// Randomised optimised-vs-scalar equivalence check (see verify.h)
+	VerifyOptions verify;
+	if (parseVerifyArgs(argc, argv, verify)) {
+		return runVerify(verify);
+	}
+
+	// Compare two recordings frame by frame (see recording.h)
+	std::string compareA, compareB;
+	if (parseCompareArgs(argc, argv, compareA, compareB)) {
+		return runCompare(compareA, compareB);
+	}
+
+	// Headless file-in/file-out render (see offline.h)
+	OfflineOptions offline;
+	bool           offlineArgsOk;
+	if (parseOfflineArgs(argc, argv, offline, offlineArgsOk)) {
+		if (!offlineArgsOk) {
+			printOfflineUsage();
+			return 2;
+		}
+		return runOffline(offline);
+	}
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
@@ -11,7 +44,20 @@ int main( ){
 
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, make_shared<ofApp>());
+	// --trace <file>: record a Chrome trace from startup, written on exit
+	// --record <file>: record the first output from startup (see recording.h)
+	// --history-mb <MB>: input history budget (see ofApp::setup())
+	auto app = make_shared<ofApp>();
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::string(argv[i]) == "--trace")      app->tracePath       = argv[i + 1];
+		if (std::string(argv[i]) == "--record")     app->recordPath      = argv[i + 1];
+		if (std::string(argv[i]) == "--history-mb") app->historyBudgetMB = ofToFloat(argv[i + 1]);
+	}
+
+	// --stream ansi|binary[:socket]: ASCII cell stream (see cellstream.h)
+	parseStreamArgs(argc, argv, app->streamOptions);
+
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
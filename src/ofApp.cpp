@@ -2,141 +2,353 @@
 
 //--------------------------------------------------------------
 void ofApp::setup(){
-	camWidth  = 640;
-	camHeight = 480;
+	designWidth  = 640;
+	designHeight = 480;
+	camWidth     = designWidth;
+	camHeight    = designHeight;
 
-	// Camera
+	// Camera (frames are drawn from the history, so no source textures)
 	myCamFeed.listDevices();
 	myCamFeed.setDeviceID(1);
+	myCamFeed.setUseTexture(false);
 	myCamFeed.initGrabber(camWidth, camHeight);
 
 	useVideo = true;
+	myVideoPlayer.setUseTexture(false);
 	myVideoPlayer.load("seba.mp4");
 	myVideoPlayer.setLoopState(OF_LOOP_NORMAL);
 	myVideoPlayer.play();
 
-	effectData = new unsigned char[camWidth * camHeight * 3];
-
-	// Initialize frame buffer
-	currentFrameIndex = 0;
-	for (int i = 0; i < NUM_FRAMES; i++) {
-		frameBuffer[i] = new unsigned char[camWidth * camHeight * 3];
-		memset(frameBuffer[i], 0, camWidth * camHeight * 3);
+	capture.setup(&myVideoPlayer, &myCamFeed);
+	capture.useVideo = useVideo;
+	previewTexture.allocate(camWidth, camHeight, GL_RGB);
+
+	asyncRemap       = true;
+	remapPending     = false;
+	remapMs          = 0;
+	remapPublished   = false;
+	publishedRemapMs = 0;
+	remapTime        = 0;
+
+	// Resolution governor (off until c)
+	governor.targetFps = 30;
+	resizePending      = false;
+
+	// Initialize frame history: about the footprint of 60 full 640x480
+	// frames, capture spares included. --history-mb raises it for long
+	// Slitscan smears.
+	if (historyBudgetMB <= 0) historyBudgetMB = 56;
+	historyRecentFrames = 30;
+	historyFormat       = FrameHistory::YCbCr420;
+	configureHistory();
+
+	// Remap threads
+	numThreads         = 0;
+	deterministicRemap = false;
+	workerPool.setThreadCount(numThreads);
+	numThreads         = workerPool.threadCount();
+
+	// --- Build outputs ---
+	// One "main" output unless outputs.json lists more. Every output loads
+	// its own presets, so no two chains share a module.
+	std::string outputsError;
+	if (!outputs.loadConfig("outputs.json", outputsError)) {
+		ofLogWarning("ofApp") << "outputs ignored: " << outputsError;
+	}
+	for (int i = 0; i < outputs.size(); i++) {
+		OutputPipeline& out = outputs[i];
+		buildPresets(out.presets);
+		out.chain.designWidth = designWidth;
+		out.allocate(camWidth, camHeight);
+		int start = out.startPreset.empty() ? 0 : out.presets.find(out.startPreset);
+		if (start < 0) ofLogWarning("ofApp") << out.name << ": no preset named " << out.startPreset;
+		out.applyPreset(std::max(start, 0));
+	}
+	for (auto& error : outputs[0].presets.errors) ofLogWarning("ofApp") << "preset skipped: " << error;
+	selectOutput(0);
+
+	// Cell stream (--stream): the first output's ASCII grid as ANSI or
+	// binary deltas. ANSI on stdout takes over the terminal, so the log
+	// goes to a file.
+	streamRenderer         = new AsciiStreamRenderer();
+	streamRenderer->follow = &outputs[0].ascii;
+	if (!streamOptions.format.empty()) {
+		if (streamOptions.format == "ansi" && streamOptions.socketPath.empty()) {
+			ofLogToFile("ofxFilters.log", true);
+		}
+		if (!streamRenderer->open(streamOptions)) {
+			ofLogWarning("ofApp") << "stream " << streamOptions.format << ":" << streamOptions.socketPath
+			                      << " not available yet";
+		}
 	}
 
-	// --- Build effect chain ---
-	waveEffect          = new WaveEffect();
-	waveEffect->enabled = true;
-	effectChain.push_back(waveEffect);
-
-	slitscanEffect          = new SlitscanEffect(NUM_FRAMES);
-	slitscanEffect->enabled = false;
-	effectChain.push_back(slitscanEffect);
-
-	blockDisplaceEffect          = new BlockDisplaceEffect();
-	blockDisplaceEffect->enabled = false;
-	effectChain.push_back(blockDisplaceEffect);
-
-	rgbSplitEffect          = new RgbSplitEffect();
-	rgbSplitEffect->enabled = true;
-	effectChain.push_back(rgbSplitEffect);
+	// --- Profiler stages ---
+	// (registration order is HUD order; fx/* stages follow when first used)
+	capture.attachProfiler(&profiler);
+	ingestStage = profiler.stage("ingest");
+	history.attachProfiler(&profiler);
+	remapStage  = profiler.stage("remap");
+	for (int i = 0; i < outputs.size(); i++) {
+		outputs[i].chain.attachProfiler(&profiler);
+		for (auto* renderer : outputs[i].renderers) renderer->attachProfiler(&profiler);
+	}
+	streamRenderer->attachProfiler(&profiler);
+	uiStage     = profiler.stage("ui");
 
-	// --- Build renderer chain ---
-	textureRenderer = new TextureRenderer();
-	textureRenderer->allocate(camWidth, camHeight);
-	renderers.push_back(textureRenderer);
+	if (!tracePath.empty()) {
+		profiler.enabled = true;
+		profiler.startTrace();
+	}
 
-	asciiRenderer          = new AsciiRenderer();
-	asciiRenderer->enabled = false;
-	renderers.push_back(asciiRenderer);
+	// Recording and playback (R / P)
+	recordOutput      = 0;
+	recordedParamsKey = 0;
+	playing           = false;
+	playerPaused      = false;
+	playFrame         = 0;
+	playerShown       = -1;
+	playTime          = 0;
+	if (!recordPath.empty()) toggleRecording();
+
+	capture.start();
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-	unsigned char* pixelData = nullptr;
-
-	if (useVideo) {
-		myVideoPlayer.update();
-		if (!myVideoPlayer.isFrameNew()) return;
-		videoFrame = myVideoPlayer.getPixels();
-		videoFrame.setImageType(OF_IMAGE_COLOR);  // normalize RGBA -> RGB
-		videoFrame.resize(camWidth, camHeight);   // match buffer row stride
-		pixelData = videoFrame.getData();
+	// Sources update here; their new frames are converted on the capture
+	// thread into the history's spare slots.
+	capture.update();
+
+	// A remap still running keeps the history and effects busy; draw()
+	// shows the last finished frame meanwhile and capture keeps queueing.
+	if (remapJob.busy()) return;
+	if (remapPending) publishRemap();
+	if (resizePending) applyProcessingSize();
+
+	// All queued frames go into the history, oldest first, so slitscan
+	// misses none. Each queue slot is swapped into the ring, not copied.
+	bool newFrame = false;
+	{
+		ProfileScope scope(profiler, ingestStage);
+		while (capture.queue.front()) {
+			history.adoptFrame(capture.queue.frontSlot());
+			capture.queue.pop();
+			newFrame = true;
+		}
+	}
+	if (!newFrame) return;
+	previewTexture.loadData(history.byAge()[0], camWidth, camHeight, GL_RGB);
+	float time = ofGetElapsedTimef();
+
+	// Remap every pixel through each output's chain into its back buffer;
+	// Feedback reads that output's last published frame
+	RemapFrame frame = { history.byAge(), history.recentDepth(), history.depth(), &history,
+	                     nullptr, camWidth, camHeight, time };
+	remapPending = true;
+	remapTime    = time;
+	auto remap = [this, frame] {
+		ProfileScope scope(profiler, remapStage);
+		int64_t t0 = Profiler::now();
+		outputs.process(frame, workerPool, deterministicRemap);
+		remapMs = (Profiler::now() - t0) / 1e6;
+	};
+	if (asyncRemap) {
+		remapJob.post(remap);
 	} else {
-		myCamFeed.update();
-		if (!myCamFeed.isFrameNew()) return;
-		pixelData = myCamFeed.getPixels().getData();
+		remap();
+		publishRemap();
 	}
-	int            nTotalBytes = camWidth * camHeight * 3;
-	float          time        = ofGetElapsedTimef();
+}
 
-	// Store current frame in circular buffer
-	memcpy(frameBuffer[currentFrameIndex], pixelData, nTotalBytes);
+//--------------------------------------------------------------
+void ofApp::publishRemap() {
+	outputs.publish();
+	remapPending     = false;
+	remapPublished   = true;
+	publishedRemapMs = remapMs;
+	if (recorder.isOpen()) recordFrame();
+}
 
-	// Process each byte (pixel channel) through the effect chain
-	for (int i = 0; i < nTotalBytes; i++) {
-		int pixelIndex = i / 3;
-		int row        = pixelIndex / camWidth;
-		int col        = pixelIndex % camWidth;
-		int channel    = i % 3;
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
 
-		PixelContext ctx(row, col, channel,
-		                 row, col, currentFrameIndex,
-		                 time, camWidth, camHeight);
+	float windowW   = ofGetWidth();
+	float windowH   = ofGetHeight();
+	float camAspect = (float)designWidth / designHeight;
 
-		for (auto* effect : effectChain) {
-			if (effect->enabled) effect->transform(ctx);
+	// Run every output's renderers, letterboxed in its viewport, or show
+	// the recording being played back; the cell stream follows the first
+	// output either way
+	int64_t renderStart = Profiler::now();
+	if (playing) {
+		drawPlayback(windowW, windowH);
+	} else {
+		for (int i = 0; i < outputs.size(); i++) {
+			OutputPipeline& out = outputs[i];
+			ofRectangle     r   = out.displayRect(windowW, windowH, camAspect);
+			for (auto* renderer : out.renderers) {
+				if (renderer->enabled) {
+					ProfileScope scope(profiler, renderer->renderStage);
+					renderer->render(out.output.front(), camWidth, camHeight, r.x, r.y, r.width, r.height);
+				}
+			}
 		}
+	}
+	if (streamRenderer->enabled) {
+		// Same rect as the first output's own ASCII renderer, which it follows
+		ofRectangle r = outputs[0].displayRect(windowW, windowH, camAspect);
+		ProfileScope scope(profiler, streamRenderer->renderStage);
+		streamRenderer->render(outputs[0].output.front(), camWidth, camHeight, r.x, r.y, r.width, r.height);
+	}
 
-		int srcIndex   = (ctx.srcRow * camWidth + ctx.srcCol) * 3 + ctx.channel;
-		effectData[i]  = frameBuffer[ctx.srcFrame][srcIndex];
+	// One governor sample per published remap: the frame it produced cost
+	// its remap plus drawing, or the larger of the two when the remap ran
+	// in the background. Draws that show no new frame are not counted.
+	if (remapPublished) {
+		remapPublished  = false;
+		double renderMs = (Profiler::now() - renderStart) / 1e6;
+		double costMs   = asyncRemap ? std::max(publishedRemapMs, renderMs) : publishedRemapMs + renderMs;
+		if (!playing && governor.addFrame(costMs)) resizePending = true;
 	}
 
-	currentFrameIndex = (currentFrameIndex + 1) % NUM_FRAMES;
+	// Source preview (top-left corner)
+	ofSetColor(255);
+	int previewW = designWidth  / 4;
+	int previewH = designHeight / 4;
+	previewTexture.draw(10, 10, previewW, previewH);
+
+	{
+		ProfileScope scope(profiler, uiStage);
+		drawUI();
+	}
+	profiler.endFrame();
 }
 
 //--------------------------------------------------------------
-void ofApp::draw(){
-	ofBackground(0);
+void ofApp::exit(){
+	remapJob.wait();
+	capture.stop();
+	streamRenderer->close();
+	recorder.close();
+	if (profiler.tracing) toggleTrace();
+}
 
-	// Compute letterboxed display rect
-	float windowW    = ofGetWidth();
-	float windowH    = ofGetHeight();
-	float camAspect  = (float)camWidth / camHeight;
-	float winAspect  = windowW / windowH;
-
-	float effectW, effectH, effectX, effectY;
-	if (winAspect > camAspect) {
-		effectH = windowH;
-		effectW = effectH * camAspect;
-		effectX = (windowW - effectW) / 2;
-		effectY = 0;
+//--------------------------------------------------------------
+// Starts or stops recording the current output. Frames are queued in
+// publishRemap(); the file is written on the recorder's own thread.
+void ofApp::toggleRecording() {
+	if (recorder.isOpen()) {
+		recorder.close();
+		ofLogNotice("ofApp") << "recorded " << recorder.frames.load() << " frames ("
+		                     << recorder.dropped.load() << " dropped) to " << recorder.path();
+		return;
+	}
+	std::string path;
+	if (!recordPath.empty()) {
+		path = ofFilePath::getAbsolutePath(recordPath, false);
+		recordPath.clear();
 	} else {
-		effectW = windowW;
-		effectH = effectW / camAspect;
-		effectX = 0;
-		effectY = (windowH - effectH) / 2;
+		ofDirectory::createDirectory("recordings", true, true);
+		path = ofToDataPath("recordings/rec_" + ofGetTimestampString("%Y%m%d_%H%M%S") + ".ofxr", true);
+	}
+	recordOutput = currentOutput;
+	recorder.open(path, current->name);
+}
+
+//--------------------------------------------------------------
+// Queues the frame just published by the recorded output, with its
+// preset as params (stored only when they change).
+void ofApp::recordFrame() {
+	OutputPipeline&    out    = outputs[std::min(recordOutput, outputs.size() - 1)];
+	const std::string& preset = out.presets[out.currentPreset].name;
+	uint64_t           key    = EffectPreset::paramsKey(preset, out.chain.modules);
+	if (key != recordedParamsKey || recordedParams.empty()) {
+		recordedParams    = EffectPreset::toJson(preset, out.chain.modules).dump();
+		recordedParamsKey = key;
+	}
+	recorder.push(out.output.front(), camWidth, camHeight, remapTime, recordedParams, recordedParamsKey);
+}
+
+//--------------------------------------------------------------
+// Plays back the file recorded last in this session, or else the newest
+// one in recordings/.
+void ofApp::togglePlayback() {
+	if (playing) {
+		playing = false;
+		player.close();
+		return;
+	}
+	std::string path = recorder.path();
+	if (path.empty()) {
+		ofDirectory dir("recordings");
+		dir.allowExt("ofxr");
+		dir.listDir();
+		dir.sort();
+		if (dir.size() > 0) path = dir.getPath(dir.size() - 1);
 	}
+	std::string error;
+	if (path.empty() || !player.open(path, error) || player.size() == 0) {
+		ofLogWarning("ofApp") << "nothing to play back " << error;
+		player.close();
+		return;
+	}
+	playing      = true;
+	playerPaused = false;
+	playerShown  = -1;
+	seekPlayback(0);
+}
 
-	// Run all renderers
-	for (auto* renderer : renderers) {
-		if (renderer->enabled) {
-			renderer->render(effectData, camWidth, camHeight,
-			                 effectX, effectY, effectW, effectH);
+//--------------------------------------------------------------
+void ofApp::seekPlayback(int frame) {
+	playFrame = std::max(0, std::min(frame, player.size() - 1));
+	playTime  = player.entry(playFrame).time;
+}
+
+//--------------------------------------------------------------
+// Advances by the recorded timestamps (looping) unless paused, and draws
+// the frame letterboxed in the window.
+void ofApp::drawPlayback(float windowW, float windowH) {
+	if (!playerPaused) {
+		int last = player.size() - 1;
+		playTime += ofGetLastFrameTime();
+		if (playTime > player.entry(last).time + 0.5) playTime = player.entry(0).time;
+		playFrame = player.findTime(playTime);
+	}
+
+	const RecordingEntry& e = player.entry(playFrame);
+	if (playFrame != playerShown) {
+		const unsigned char* rgb = player.frame(playFrame);
+		if (!rgb) {
+			ofLogError("ofApp") << "recording damaged at frame " << playFrame;
+			togglePlayback();
+			return;
+		}
+		if (playerTexture.getWidth() != e.width || playerTexture.getHeight() != e.height) {
+			playerTexture.allocate(e.width, e.height, GL_RGB);
 		}
+		playerTexture.loadData(rgb, e.width, e.height, GL_RGB);
+		playerShown = playFrame;
 	}
 
-	// Source preview (top-left corner)
+	float aspect = (float)e.width / e.height;
+	float w      = std::min(windowW, windowH * aspect);
+	float h      = w / aspect;
 	ofSetColor(255);
-	int previewW = camWidth  / 4;
-	int previewH = camHeight / 4;
-	if (useVideo) {
-		myVideoPlayer.draw(10, 10, previewW, previewH);
-	} else {
-		myCamFeed.draw(10, 10, previewW, previewH);
-	}
+	playerTexture.draw((windowW - w) / 2, (windowH - h) / 2, w, h);
+}
 
-	drawUI();
+//--------------------------------------------------------------
+void ofApp::toggleTrace() {
+	if (!profiler.tracing) {
+		profiler.enabled = true;
+		profiler.startTrace();
+		return;
+	}
+	std::string path = !tracePath.empty() ? ofFilePath::getAbsolutePath(tracePath, false)
+	                                      : ofToDataPath("trace_" + ofGetTimestampString() + ".json", true);
+	if (profiler.writeTrace(path)) ofLogNotice("ofApp") << "trace written to " << path;
+	else                           ofLogError("ofApp")  << "cannot write trace to " << path;
 }
 
 //--------------------------------------------------------------
@@ -149,32 +361,114 @@ void ofApp::drawUI() {
 	ofColor offColor = ofColor(130, 130, 130);
 	ofColor dimColor = ofColor(160, 160, 160);
 
+	TextureRenderer& texture = current->texture;
+	AsciiRenderer&   ascii   = current->ascii;
+
 	auto badge     = [](bool b) -> std::string { return b ? "[ON ] " : "[OFF] "; };
 	auto itemColor = [&](bool b) -> ofColor    { return b ? onColor : offColor; };
 
 	std::string sourceLabel = useVideo ? "[VIDEO] v: cam  p: play/pause"
 	                                   : "[CAM]   v: video";
+	std::string captureLabel = std::string("capture: ") + (capture.running() ? "async" : "sync ")
+	                         + "  dropped: " + ofToString(capture.dropped.load()) + "   g: async on/off";
+
+	std::string recordLabel = "      off";
+	if (recorder.failed) {
+		recordLabel = "      " + recorder.error();
+	} else if (recorder.isOpen()) {
+		recordLabel = "      [REC] " + outputs[std::min(recordOutput, outputs.size() - 1)].name + "  "
+		            + ofToString(recorder.frames.load()) + " frames  "
+		            + ofToString(recorder.bytes.load() >> 20) + "MB  dropped: "
+		            + ofToString(recorder.dropped.load()) + (recorder.full ? "  FULL" : "");
+	}
+	std::string playLabel = !playing ? std::string("      playback off") :
+		"      " + player.output() + "  " + ofToString(playFrame + 1) + "/" + ofToString(player.size())
+		+ "  " + ofToString(player.entry(playFrame).time - player.entry(0).time, 2) + "s"
+		+ (playerPaused ? "  paused" : "") + "   space  left/right  drag";
 
 	using P = std::pair<std::string, ofColor>;
+
+	// Effects the current preset does not contain show as [ -- ]
+	auto effectLine = [&](EffectModule* m, const std::string& label, const std::string& detail) -> P {
+		if (!m) return {"[ -- ] " + label, offColor};
+		return {badge(m->enabled) + label + detail, itemColor(m->enabled)};
+	};
 	std::vector<P> lines = {
 		{"EFFECTS                     FPS: " + ofToString((int)ofGetFrameRate()), white},
 		{sourceLabel, dimColor},
-		{badge(waveEffect->enabled)          + "1: Wave",                         itemColor(waveEffect->enabled)},
-		{badge(rgbSplitEffect->enabled)      + "2: RGB Split",                    itemColor(rgbSplitEffect->enabled)},
-		{badge(slitscanEffect->enabled)      + "3: Slitscan    depth: "
-		     + ofToString(slitscanEffect->depth),                                  itemColor(slitscanEffect->enabled)},
-		{badge(blockDisplaceEffect->enabled) + "4: BlockDisp   size: "
-		     + ofToString(blockDisplaceEffect->blockSize) + "  amt: "
-		     + ofToString(blockDisplaceEffect->blockAmount, 1),                    itemColor(blockDisplaceEffect->enabled)},
+		{captureLabel, dimColor},
+		{"threads: " + ofToString(workerPool.threadCount())
+		     + (deterministicRemap ? "  deterministic" : "  dynamic")
+		     + "   -/=: threads  \\: mode",                                  dimColor},
+		{"kernels: " + std::string(remapKernels().name) + "   k: simd on/off"
+		     + (current->baked ? "   remap: baked" : current->fused ? "   remap: fused" : "   remap: live"), dimColor},
+		{std::string("chain: ") + (current->chain.useFused ? "fused  " : "generic")
+		     + (fixedPointSine() ? "  sine: fixed" : "  sine: float")
+		     + "   x: fused  j: fixed",                                             dimColor},
+		{std::string("output: ") + (asyncRemap ? "async remap" : "sync remap ")
+		     + (texture.pboActive() ? "  pbo upload" : "  direct upload")
+		     + "   r: async  u: pbo",                                               dimColor},
+		{"size: " + ofToString(camWidth) + "x" + ofToString(camHeight)
+		     + (governor.enabled ? "  governor @" + ofToString((int)governor.targetFps) + "fps"
+		                         : std::string("  fixed"))
+		     + "   c: governor  ;: target",                                       dimColor},
+		{"pipeline: " + current->name + " (" + ofToString(currentOutput + 1) + "/"
+		     + ofToString(outputs.size()) + ")   tab: next",                          dimColor},
+		{"preset: " + current->presets[current->currentPreset].name
+		     + " (" + ofToString(current->currentPreset + 1) + "/" + ofToString(current->presets.size())
+		     + ", " + ofToString(current->chain.modules.size())
+		     + " modules)   [ ]: switch  o: save",                                  dimColor},
+		effectLine(waveEffect, "1: Wave", !waveEffect ? "" :
+		     (waveEffect->subpixel ? "        subpx (z)" : "        pixel (z)")
+		     + std::string(waveEffect->paused ? "  paused (f)" : "")),
+		effectLine(rgbSplitEffect, "2: RGB Split", ""),
+		effectLine(slitscanEffect, "3: Slitscan", !slitscanEffect ? "" :
+		     "    depth: " + ofToString(slitscanEffect->depth)
+		     + (slitscanEffect->subpixel ? "  blend (l)" : "  bands (l)")),
+		{"      history: " + ofToString(history.recentDepth()) + " full + "
+		     + ofToString(history.olderDepth()) + " " + FrameHistory::formatName(historyFormat)
+		     + "  " + ofToString(history.allocatedBytes() >> 20) + "MB  (h)",    dimColor},
+		effectLine(blockDisplaceEffect, "4: BlockDisp", !blockDisplaceEffect ? "" :
+		     "   size: " + ofToString(blockDisplaceEffect->blockSize) + "  amt: "
+		     + ofToString(blockDisplaceEffect->blockAmount, 1)),
+		effectLine(feedbackEffect, "7: Feedback", !feedbackEffect ? "" :
+		     "    mix: " + ofToString(feedbackEffect->mix, 2) + " (8/9)  zoom: "
+		     + ofToString(feedbackEffect->zoom, 2)),
 		{"", white},
 		{"RENDERERS", white},
-		{badge(textureRenderer->enabled) + "0: Texture",                          itemColor(textureRenderer->enabled)},
-		{badge(asciiRenderer->enabled)   + "5: ASCII",                            itemColor(asciiRenderer->enabled)},
-		{"      mode: " + std::string(colorModeNames[asciiRenderer->colorMode % 3])
-		     + "  size: " + ofToString(asciiRenderer->cellW)
-		     + "  chars: " + std::string(charSetNames[asciiRenderer->charSetIndex % 4]), dimColor},
+		{badge(texture.enabled)         + "0: Texture",                           itemColor(texture.enabled)},
+		{badge(ascii.enabled)           + "5: ASCII",                             itemColor(ascii.enabled)},
+		{"      mode: " + std::string(colorModeNames[ascii.colorMode % 3])
+		     + "  size: " + ofToString(ascii.cellW)
+		     + "  chars: " + std::string(charSetNames[ascii.charSetIndex % 4])
+		     + (ascii.areaSample ? "  area (b)" : "  point (b)"),                  dimColor},
+		{badge(streamRenderer->enabled) + "i: Stream",                            itemColor(streamRenderer->enabled)},
+		{!streamRenderer->sink.isOpen() ? "      off (start with --stream)" :
+		     "      " + std::string(streamRenderer->format == AsciiStreamRenderer::Ansi ? "ansi " : "binary ")
+		     + streamRenderer->sink.describe() + (streamRenderer->sink.connected() ? "" : " (waiting)")
+		     + "  " + ofToString(streamRenderer->stats.bytes) + "B  " + ofToString(streamRenderer->stats.cells)
+		     + " cells  backlog: " + ofToString(streamRenderer->stats.backlogCells),  dimColor},
+		{"", white},
+		{"RECORD   R: start/stop  P: play",                                    white},
+		{recordLabel,                                                          dimColor},
+		{playLabel,                                                            dimColor},
+		{"", white},
+		{std::string("PROFILE  t: ") + (profiler.enabled ? "on " : "off")
+		     + "  y: trace" + (profiler.tracing ? " [REC]" : ""),                white},
 	};
 
+	// Rolling p50 / p99 per stage, in ms. fx/* stages are summed over workers.
+	if (profiler.enabled) {
+		char buf[96];
+		lines.push_back({"  stage                   p50ms   p99ms", dimColor});
+		for (int s = 0; s < profiler.numStages(); s++) {
+			if (!profiler.hasSamples(s)) continue;
+			snprintf(buf, sizeof(buf), "  %-22s %7.2f %7.2f",
+			         profiler.stageName(s).c_str(), profiler.p50(s), profiler.p99(s));
+			lines.push_back({buf, dimColor});
+		}
+	}
+
 	const int lineH  = 16;
 	const int padX   = 10;
 	const int padY   = 8;
@@ -197,34 +491,198 @@ void ofApp::drawUI() {
 	ofSetColor(255);
 }
 
+//--------------------------------------------------------------
+// Reallocates everything sized by the processing resolution. The history
+// restarts empty; the governor's settle frames cover the refill.
+void ofApp::applyProcessingSize() {
+	resizePending = false;
+	governor.size(designWidth, designHeight, camWidth, camHeight);
+	previewTexture.allocate(camWidth, camHeight, GL_RGB);
+	outputs.allocate(camWidth, camHeight);
+	configureHistory();
+}
+
+//--------------------------------------------------------------
+// The capture thread fills the history's spare slots, so it stops while
+// they are re-laid out.
+void ofApp::configureHistory() {
+	bool wasCapturing = capture.running();
+	capture.stop();
+	history.configure(camWidth, camHeight, historyBudgetMB, historyRecentFrames, historyFormat,
+	                  CaptureThread::kSpareFrames);
+	capture.bind(history);
+	if (wasCapturing) capture.start();
+	fitSlitscans();
+}
+
+//--------------------------------------------------------------
+// Slitscan depths follow the history, whichever preset or output they
+// came from.
+void ofApp::fitSlitscans() {
+	for (int i = 0; i < outputs.size(); i++) {
+		for (auto* m : outputs[i].chain.modules) {
+			if (auto* slit = dynamic_cast<SlitscanEffect*>(m)) {
+				slit->numFrames = history.depth();
+				slit->depth     = std::min(slit->depth, history.depth() - 1);
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+// The built-in chain is preset 0; presets/*.json follow.
+void ofApp::buildPresets(PresetLibrary& library) {
+	std::unique_ptr<EffectPreset> builtIn(new EffectPreset());
+	builtIn->name = "default";
+	builtIn->add(new WaveEffect(),                    true);
+	builtIn->add(new SlitscanEffect(history.depth()), false);
+	builtIn->add(new BlockDisplaceEffect(),           false);
+	builtIn->add(new RgbSplitEffect(),                true);
+	builtIn->add(new FeedbackEffect(),                false);
+	library.add(std::move(builtIn));
+	library.loadFolder("presets");
+}
+
+//--------------------------------------------------------------
+void ofApp::selectOutput(int index) {
+	currentOutput = (index % outputs.size() + outputs.size()) % outputs.size();
+	current       = &outputs[currentOutput];
+	applyPreset(current->currentPreset);
+}
+
+//--------------------------------------------------------------
+void ofApp::applyPreset(int index) {
+	current->applyPreset(index);
+
+	EffectChain& chain  = current->chain;
+	waveEffect          = chain.find<WaveEffect>();
+	slitscanEffect      = chain.find<SlitscanEffect>();
+	blockDisplaceEffect = chain.find<BlockDisplaceEffect>();
+	rgbSplitEffect      = chain.find<RgbSplitEffect>();
+	feedbackEffect      = chain.find<FeedbackEffect>();
+	fitSlitscans();
+}
+
+//--------------------------------------------------------------
+void ofApp::saveCurrentPreset() {
+	std::string name = "saved_" + ofGetTimestampString("%Y%m%d_%H%M%S");
+	ofDirectory::createDirectory("presets", true, true);
+	std::string path = "presets/" + name + ".json";
+	if (ofSavePrettyJson(path, EffectPreset::toJson(name, current->chain.modules))) {
+		ofLogNotice("ofApp") << "preset saved to " << ofToDataPath(path, true);
+	}
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+	// Everything below may touch state the background remap reads
+	remapJob.wait();
+
 	// Source toggle
-	if (key == 'v') useVideo = !useVideo;
-	if (key == 'p' && useVideo) myVideoPlayer.setPaused(!myVideoPlayer.isPaused());
+	if (key == 'v') capture.useVideo = useVideo = !useVideo;
+	if (key == 'p' && useVideo) capture.paused = !capture.paused;
+	if (key == 'g') {
+		if (capture.running()) capture.stop();
+		else                   capture.start();
+	}
+
+	// Remap threads
+	if (key == '-')  numThreads = std::max(numThreads - 1, 1);
+	if (key == '=')  numThreads = std::min(numThreads + 1, 64);
+	if (key == '-' || key == '=') workerPool.setThreadCount(numThreads);
+	if (key == '\\') deterministicRemap = !deterministicRemap;
+	if (key == 'k')  useSimdKernels(&remapKernels() == &scalarKernels());
+	if (key == 'r')  asyncRemap = !asyncRemap;
+	if (key == 'u') {
+		bool pbo = !current->texture.usePbo;
+		for (int i = 0; i < outputs.size(); i++) outputs[i].texture.usePbo = pbo;
+	}
+	if (key == 'x')  current->chain.useFused = !current->chain.useFused;
+	if (key == 'j')  useFixedPointSine(!fixedPointSine());
+
+	// Resolution governor; off returns to the design size
+	if (key == 'c') {
+		governor.enabled = !governor.enabled;
+		governor.reset();
+		if (!governor.enabled && governor.level != 0) {
+			governor.level = 0;
+			resizePending  = true;
+		}
+	}
+	if (key == ';') {
+		const float targets[] = { 24, 30, 50, 60 };
+		int i = 0;
+		while (i < 3 && targets[i] <= governor.targetFps) i++;
+		governor.targetFps = governor.targetFps >= 60 ? targets[0] : targets[i];
+		governor.reset();
+	}
 
-	// Toggle effects
-	if (key == '1') waveEffect->enabled         = !waveEffect->enabled;
-	if (key == '2') rgbSplitEffect->enabled      = !rgbSplitEffect->enabled;
-	if (key == '3') slitscanEffect->enabled      = !slitscanEffect->enabled;
-	if (key == '4') blockDisplaceEffect->enabled = !blockDisplaceEffect->enabled;
+	// Profiling
+	if (key == 't') profiler.enabled = !profiler.enabled;
+	if (key == 'y') toggleTrace();
+
+	// Recording and playback
+	if (key == 'R') toggleRecording();
+	if (key == 'P') togglePlayback();
+	if (playing) {
+		if (key == ' ')           playerPaused = !playerPaused;
+		if (key == OF_KEY_LEFT)   { playerPaused = true; seekPlayback(playFrame - 1); }
+		if (key == OF_KEY_RIGHT)  { playerPaused = true; seekPlayback(playFrame + 1); }
+	}
+
+	// Outputs and presets (keys below act on the current output)
+	if (key == OF_KEY_TAB) selectOutput(currentOutput + 1);
+	if (key == '[') applyPreset(current->currentPreset - 1);
+	if (key == ']') applyPreset(current->currentPreset + 1);
+	if (key == 'o') saveCurrentPreset();
+
+	// Toggle effects (the first of each type in the preset, if any)
+	if (waveEffect) {
+		if (key == '1') waveEffect->enabled  = !waveEffect->enabled;
+		if (key == 'f') waveEffect->setPaused(!waveEffect->paused, ofGetElapsedTimef());
+		if (key == 'z') waveEffect->subpixel = !waveEffect->subpixel;
+	}
+	if (rgbSplitEffect && key == '2') rgbSplitEffect->enabled = !rgbSplitEffect->enabled;
+	if (slitscanEffect) {
+		if (key == '3') slitscanEffect->enabled  = !slitscanEffect->enabled;
+		if (key == 'l') slitscanEffect->subpixel = !slitscanEffect->subpixel;
+	}
+	if (blockDisplaceEffect && key == '4') blockDisplaceEffect->enabled = !blockDisplaceEffect->enabled;
+	if (feedbackEffect) {
+		if (key == '7') feedbackEffect->enabled = !feedbackEffect->enabled;
+		if (key == '8') feedbackEffect->mix     = std::max(feedbackEffect->mix - 0.05f, 0.0f);
+		if (key == '9') feedbackEffect->mix     = std::min(feedbackEffect->mix + 0.05f, 1.0f);
+	}
+	if (key == 'h') {
+		historyFormat = (FrameHistory::Format)((historyFormat + 1) % FrameHistory::kNumFormats);
+		configureHistory();
+	}
 
 	// Toggle / configure renderers
-	if (key == '0') textureRenderer->enabled     = !textureRenderer->enabled;
-	if (key == '5') asciiRenderer->enabled       = !asciiRenderer->enabled;
-	if (key == '6') asciiRenderer->colorMode     = (asciiRenderer->colorMode + 1) % 3;
-	if (key == 'm') asciiRenderer->cellW         = std::max(asciiRenderer->cellW - 2, 4);
-	if (key == 'n') asciiRenderer->cellW         = std::min(asciiRenderer->cellW + 2, 32);
-	if (key == ',') asciiRenderer->charSetIndex  = (asciiRenderer->charSetIndex - 1 + 4) % 4;
-	if (key == '.') asciiRenderer->charSetIndex  = (asciiRenderer->charSetIndex + 1) % 4;
+	TextureRenderer& texture = current->texture;
+	AsciiRenderer&   ascii   = current->ascii;
+	if (key == '0') texture.enabled         = !texture.enabled;
+	if (key == '5') ascii.enabled           = !ascii.enabled;
+	if (key == 'i') streamRenderer->enabled = !streamRenderer->enabled;
+	if (key == '6') ascii.colorMode         = (ascii.colorMode + 1) % 3;
+	if (key == 'm') ascii.cellW             = std::max(ascii.cellW - 2, 4);
+	if (key == 'n') ascii.cellW             = std::min(ascii.cellW + 2, 32);
+	if (key == ',') ascii.charSetIndex      = (ascii.charSetIndex - 1 + 4) % 4;
+	if (key == '.') ascii.charSetIndex      = (ascii.charSetIndex + 1) % 4;
+	if (key == 'b') ascii.areaSample        = !ascii.areaSample;
 
 	// Effect parameters
-	if (key == 'q') slitscanEffect->depth           = std::min(slitscanEffect->depth + 5, 59);
-	if (key == 'a') slitscanEffect->depth           = std::max(slitscanEffect->depth - 5, 1);
-	if (key == 'w') blockDisplaceEffect->blockSize  = std::min(blockDisplaceEffect->blockSize + 4, 64);
-	if (key == 's') blockDisplaceEffect->blockSize  = std::max(blockDisplaceEffect->blockSize - 4, 4);
-	if (key == 'e') blockDisplaceEffect->blockAmount += 2.0f;
-	if (key == 'd') blockDisplaceEffect->blockAmount = std::max(blockDisplaceEffect->blockAmount - 2.0f, 0.0f);
+	int depthStep = std::max(5, history.depth() / 24);
+	if (slitscanEffect) {
+		if (key == 'q') slitscanEffect->depth = std::min(slitscanEffect->depth + depthStep, history.depth() - 1);
+		if (key == 'a') slitscanEffect->depth = std::max(slitscanEffect->depth - depthStep, 1);
+	}
+	if (blockDisplaceEffect) {
+		if (key == 'w') blockDisplaceEffect->blockSize  = std::min(blockDisplaceEffect->blockSize + 4, 64);
+		if (key == 's') blockDisplaceEffect->blockSize  = std::max(blockDisplaceEffect->blockSize - 4, 4);
+		if (key == 'e') blockDisplaceEffect->blockAmount += 2.0f;
+		if (key == 'd') blockDisplaceEffect->blockAmount = std::max(blockDisplaceEffect->blockAmount - 2.0f, 0.0f);
+	}
 }
 
 //--------------------------------------------------------------
@@ -239,12 +697,13 @@ void ofApp::mouseMoved(int x, int y ){
 
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button){
-
+	// Scrub the recording across the window width
+	if (playing) seekPlayback((int)((float)x / ofGetWidth() * player.size()));
 }
 
 //--------------------------------------------------------------
 void ofApp::mousePressed(int x, int y, int button){
-
+	mouseDragged(x, y, button);
 }
 
 //--------------------------------------------------------------
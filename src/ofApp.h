@@ -2,7 +2,16 @@
 
 #include "ofMain.h"
 #include "effects.h"
+#include "pipeline.h"
+#include "history.h"
 #include "renderers.h"
+#include "cellstream.h"
+#include "profiler.h"
+#include "capture.h"
+#include "presets.h"
+#include "governor.h"
+#include "outputs.h"
+#include "recording.h"
 
 class ofApp : public ofBaseApp{
 
@@ -10,6 +19,7 @@ class ofApp : public ofBaseApp{
 		void setup();
 		void update();
 		void draw();
+		void exit();
 
 		void drawUI();
 
@@ -27,28 +37,113 @@ class ofApp : public ofBaseApp{
 
 		ofVideoGrabber myCamFeed;
 		ofVideoPlayer  myVideoPlayer;
-		ofPixels       videoFrame;   // RGB conversion buffer for video
 		bool           useVideo;
 
-		unsigned char* effectData;
+		// Sources update in update(); conversion runs on a producer thread
+		// (g: toggle) into the history's spare slots, and update() swaps the
+		// queued ones into the ring. previewTexture shows the newest input.
+		CaptureThread capture;
+		ofTexture     previewTexture;
 
+		// Named output pipelines (bin/data/outputs.json), each with its own
+		// presets, effect chain, double-buffered output and renderers, all
+		// fed from the one history. The remap of every output fills its
+		// output.back() on a background job (r: on/off) while draw() shows
+		// output.front(). Keys and the HUD act on `current` (tab: next).
+		OutputSet       outputs;
+		OutputPipeline* current;
+		int             currentOutput;
+		BackgroundJob   remapJob;
+		bool            asyncRemap;
+		bool            remapPending;
+
+		float           remapTime;    // effect time of the frame in flight
+
+		void publishRemap();
+		void selectOutput(int index);
+		void buildPresets(PresetLibrary& library);
+
+		// Processing size (camWidth x camHeight) is the design size scaled
+		// by the resolution governor (c: on/off, ;: target fps). Effect
+		// parameters are in design pixels; the texture renderer upscales.
 		int camWidth;
 		int camHeight;
+		int designWidth;
+		int designHeight;
+
+		ResolutionGovernor  governor;
+		bool                resizePending;
+		std::atomic<double> remapMs;            // last remap (written by the job)
+		bool                remapPublished;     // one finished since the last draw()
+		double              publishedRemapMs;   // and its remapMs
+
+		void applyProcessingSize();
+
+		// Input history for slitscan (frames addressed by age), sized by a
+		// memory budget: recent frames at full res, older ones compact.
+		// historyBudgetMB is set from --history-mb before setup() (0 = default).
+		float                historyBudgetMB = 0;
+		int                  historyRecentFrames;
+		FrameHistory::Format historyFormat;
+		FrameHistory         history;
+
+		void configureHistory();
+		void fitSlitscans();
 
-		// Frame buffer for slitscan
-		static const int NUM_FRAMES = 60;
-		unsigned char* frameBuffer[60];
-		int currentFrameIndex;
+		// Remap worker threads (0 = one per core)
+		WorkerPool workerPool;
+		int        numThreads;
+		bool       deterministicRemap;
 
-		// Effect chain (ordered; each module modifies PixelContext)
-		std::vector<EffectModule*> effectChain;
+		// Effect presets, per output: [0] is the built-in chain, then every
+		// bin/data/presets/*.json ([ / ]: switch, o: save the current chain).
+		// Switching swaps the chain's modules; the presets own the modules.
+		void applyPreset(int index);
+		void saveCurrentPreset();
+
+		// First module of each built-in type in the current output's chain,
+		// or nullptr when its preset has none. Keys and the HUD go through
+		// these.
 		WaveEffect*          waveEffect;
 		SlitscanEffect*      slitscanEffect;
 		BlockDisplaceEffect* blockDisplaceEffect;
 		RgbSplitEffect*      rgbSplitEffect;
+		FeedbackEffect*      feedbackEffect;
+
+		// Cell stream of the first output, on its ASCII grid settings
+		AsciiStreamRenderer* streamRenderer;
+
+		// Set from --stream* before setup() (see cellstream.h)
+		StreamOptions streamOptions;
+
+		// Recording of one output's published frames to
+		// bin/data/recordings/*.ofxr (R: start/stop; recordPath is set from
+		// --record and records the first output from startup), and playback
+		// of the last recording in place of the outputs (P: on/off, space:
+		// pause, left/right: step, drag: scrub). See recording.h.
+		FrameRecorder recorder;
+		int           recordOutput;
+		uint64_t      recordedParamsKey;   // paramsKey() of recordedParams
+		std::string   recordedParams;      // preset JSON last recorded
+		std::string   recordPath;
+		FramePlayer   player;
+		ofTexture     playerTexture;
+		bool          playing, playerPaused;
+		int           playFrame, playerShown;
+		double        playTime;     // recording time, seconds
+
+		void toggleRecording();
+		void recordFrame();
+		void togglePlayback();
+		void seekPlayback(int frame);
+		void drawPlayback(float windowW, float windowH);
+
+		// Per-stage timing (t: HUD on/off, y: start/stop a Chrome trace).
+		// tracePath is set from --trace; it records from startup and is
+		// written on exit.
+		Profiler    profiler;
+		int         ingestStage, remapStage, uiStage;
+		std::string tracePath;
 
-		// Renderer chain (each reads effectData and draws)
-		std::vector<Renderer*> renderers;
-		TextureRenderer* textureRenderer;
-		AsciiRenderer*   asciiRenderer;
+		void toggleTrace();
 };
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "ofMain.h"
+#include "effects.h"
+#include "pipeline.h"
+#include "history.h"
+#include "presets.h"
+#include "recording.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// ---------------------------------------------------------------------------
+// Offline render — headless file-in/file-out mode.
+//
+//   ofxFilters --render <video file | image dir> --out <dir> | --record <file.ofxr>
+//              [--effects wave,slitscan,blockdisplace,rgbsplit | --preset file.json]
+//              [--set wave.hAmount=12 ...] [--fps 30] [--frames N]
+//              [--size 640x480] [--threads N] [--history-mb 512]
+//              [--format png|jpg|bmp|tga]
+//
+// Runs the same FrameHistory → EffectChain path as ofApp::update(), as
+// fast as possible, with time = frameIndex / fps. No window, GL context or
+// camera is created. --effects gives the chain order; all listed modules
+// are enabled. --preset loads a saved effect graph instead (see presets.h);
+// --set applies on top of either, to every module whose name or type
+// ("wave", or a preset's own module name) matches, ignoring case. --record
+// writes the frames to a recording (see recording.h) as well as, or instead
+// of, images; recordings of two builds can then be checked with --compare.
+// Unknown options and options without a value print the usage and exit
+// with code 2. Prints a timing summary to stdout when done.
+// ---------------------------------------------------------------------------
+struct OfflineOptions {
+    std::string input;
+    std::string outputDir;
+    std::string recordPath;
+    std::string format     = "png";
+    std::vector<std::string> effects = { "wave", "rgbsplit" };
+    std::string preset;
+    std::vector<std::string> sets;     // "module.param=value"
+    float fps        = 30.0f;
+    int   maxFrames  = -1;
+    int   width      = 640;
+    int   height     = 480;
+    int   threads    = 0;
+    float historyMB  = 512.0f;
+};
+
+inline void printOfflineUsage() {
+    std::fprintf(stderr,
+        "usage: ofxFilters --render <video|image dir> --out <dir> | --record <file.ofxr>\n"
+        "                  [--effects wave,slitscan,blockdisplace,rgbsplit | --preset file.json]\n"
+        "                  [--set module.param=value]... [--fps 30] [--frames N]\n"
+        "                  (module: effect type or module name, e.g. wave.hAmount=12)\n"
+        "                  [--size WxH] [--threads N] [--history-mb MB]\n"
+        "                  [--format png|jpg|bmp|tga]\n");
+}
+
+// Returns false if argv does not ask for an offline render. Sets `ok` to
+// false when it does but the arguments are invalid: an unknown "--" option,
+// an option without a value (every one takes one) or a missing output.
+inline bool parseOfflineArgs(int argc, char* argv[], OfflineOptions& o, bool& ok) {
+    ok = true;
+    bool render = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a.compare(0, 2, "--") != 0) continue;
+        if (a == "--render") render = true;
+        if (i + 1 == argc || std::string(argv[i + 1]).compare(0, 2, "--") == 0) {
+            ok = false;
+            continue;
+        }
+        std::string v = argv[++i];
+        if      (a == "--render")     o.input      = v;
+        else if (a == "--out")        o.outputDir  = v;
+        else if (a == "--record")     o.recordPath = v;
+        else if (a == "--effects")    o.effects    = ofSplitString(v, ",", true, true);
+        else if (a == "--preset")     o.preset     = v;
+        else if (a == "--set")        o.sets.push_back(v);
+        else if (a == "--fps")        o.fps        = ofToFloat(v);
+        else if (a == "--frames")     o.maxFrames  = ofToInt(v);
+        else if (a == "--threads")    o.threads    = ofToInt(v);
+        else if (a == "--history-mb") o.historyMB  = ofToFloat(v);
+        else if (a == "--format")     o.format     = v;
+        else if (a == "--size") {
+            std::vector<std::string> wh = ofSplitString(v, "x");
+            if (wh.size() == 2) { o.width = ofToInt(wh[0]); o.height = ofToInt(wh[1]); }
+            else ok = false;
+        }
+        else ok = false;
+    }
+    if (!render) return false;
+    if ((o.outputDir.empty() && o.recordPath.empty()) || o.fps <= 0 || o.width <= 0 || o.height <= 0) ok = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// OfflineSource — pulls frames from a video file or a sorted image folder.
+// ---------------------------------------------------------------------------
+struct OfflineSource {
+    static const int kDecodeTimeoutSec = 5;
+
+    ofVideoPlayer            player;
+    std::vector<std::string> images;
+    ofPixels                 imagePixels;
+    int                      next = 0;
+    bool                     isVideo = false;
+
+    bool open(const std::string& path) {
+        ofDirectory dir(path);
+        if (dir.isDirectory()) {
+            for (auto ext : { "png", "jpg", "jpeg", "bmp", "tga", "tif", "tiff" }) dir.allowExt(ext);
+            dir.listDir();
+            dir.sort();
+            for (size_t i = 0; i < dir.size(); i++) images.push_back(dir.getPath(i));
+            return !images.empty();
+        }
+        isVideo = true;
+        player.setUseTexture(false);
+        if (!player.load(path)) return false;
+        player.setLoopState(OF_LOOP_NONE);
+        player.play();
+        player.setPaused(true);
+        return true;
+    }
+
+    // Next frame, or nullptr at the end of the input. Seeks are decoded
+    // asynchronously by some players, so update() repeats until the frame
+    // is new; a movie that ends first ends the input rather than repeating
+    // its last frame.
+    const ofPixels* read() {
+        if (!isVideo) {
+            if (next >= (int)images.size()) return nullptr;
+            if (!ofLoadImage(imagePixels, images[next++])) return nullptr;
+            return &imagePixels;
+        }
+        int total = player.getTotalNumFrames();
+        if (total > 0 && next >= total) return nullptr;
+        if (next == 0) player.setFrame(0);
+        else           player.nextFrame();
+        next++;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(kDecodeTimeoutSec);
+        while (true) {
+            player.update();
+            if (player.isFrameNew()) return &player.getPixels();
+            if (player.getIsMovieDone() || std::chrono::steady_clock::now() > deadline) return nullptr;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+inline int runOffline(const OfflineOptions& o) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    ofInit();
+
+    // Paths on the command line are relative to the working directory,
+    // not to bin/data like everything else in OF.
+    std::string input     = ofFilePath::getAbsolutePath(o.input, false);
+    std::string outputDir = o.outputDir.empty() ? "" : ofFilePath::getAbsolutePath(o.outputDir, false);
+
+    OfflineSource source;
+    if (!source.open(input)) {
+        std::fprintf(stderr, "offline: cannot open input '%s'\n", input.c_str());
+        return 1;
+    }
+    if (!outputDir.empty() && !ofDirectory::createDirectory(outputDir, false, true)) {
+        std::fprintf(stderr, "offline: cannot create output dir '%s'\n", outputDir.c_str());
+        return 1;
+    }
+
+    FrameHistory history;
+    history.configure(o.width, o.height, o.historyMB, 60, FrameHistory::YCbCr420);
+
+    // Build the scripted chain
+    EffectPreset preset;
+    if (!o.preset.empty()) {
+        PresetLibrary library;
+        if (!library.loadFile(ofFilePath::getAbsolutePath(o.preset, false))) {
+            std::fprintf(stderr, "offline: bad preset %s\n", library.errors[0].c_str());
+            return 2;
+        }
+        preset = std::move(library[0]);
+    } else {
+        for (auto& name : o.effects) {
+            EffectModule* m = makeEffect(name);
+            if (!m) {
+                std::fprintf(stderr, "offline: unknown effect '%s'\n", name.c_str());
+                return 2;
+            }
+            preset.add(m, true);
+        }
+    }
+    EffectChain chain;
+    chain.useLut  = true;
+    chain.modules = preset.chain();
+    for (auto* m : chain.modules) {
+        if (auto* slit = dynamic_cast<SlitscanEffect*>(m)) slit->numFrames = history.depth();
+    }
+    for (auto& set : o.sets) {
+        size_t dot = set.find('.'), eq = set.find('=');
+        bool applied = false;
+        if (dot != std::string::npos && eq != std::string::npos && dot < eq) {
+            std::string module = set.substr(0, dot);
+            std::string param  = set.substr(dot + 1, eq - dot - 1);
+            float       value  = ofToFloat(set.substr(eq + 1));
+            auto matches = [&](const std::string& n) {
+                return std::equal(n.begin(), n.end(), module.begin(), module.end(),
+                                  [](char a, char b) { return ::tolower(a) == ::tolower(b); });
+            };
+            for (auto* m : chain.modules) {
+                if (matches(m->name) || matches(m->type)) applied |= m->setParam(param, value);
+            }
+        }
+        if (!applied) {
+            std::fprintf(stderr, "offline: cannot apply '--set %s'\n", set.c_str());
+            return 2;
+        }
+    }
+
+    WorkerPool pool(o.threads);
+    OutputBuffers output;   // front() feeds FeedbackEffect
+    output.allocate(o.width, o.height);
+    ofPixels outPixels;
+
+    // Frames queue for the writer thread and wait for it rather than drop;
+    // the preset JSON is rebuilt only when its parameters change
+    FrameRecorder recorder;
+    std::string   params;
+    uint64_t      paramsKey = 0;
+    if (!o.recordPath.empty()) recorder.open(ofFilePath::getAbsolutePath(o.recordPath, false), "offline");
+
+    double readMs = 0, remapMs = 0, writeMs = 0;
+    auto   start  = Clock::now();
+    int    frame  = 0;
+    char   name[64];
+
+    while (o.maxFrames < 0 || frame < o.maxFrames) {
+        auto t0 = Clock::now();
+        const ofPixels* px = source.read();
+        if (!px) break;
+        history.pushPixels(*px);
+        auto t1 = Clock::now();
+
+        RemapFrame f = { history.byAge(), history.recentDepth(), history.depth(), &history,
+                         output.back(), o.width, o.height, frame / o.fps, output.front() };
+        chain.process(f, pool);
+        output.publish();
+        auto t2 = Clock::now();
+
+        if (recorder.isOpen()) {
+            uint64_t key = EffectPreset::paramsKey(preset.name, chain.modules);
+            if (key != paramsKey || params.empty()) {
+                params    = EffectPreset::toJson(preset.name, chain.modules).dump();
+                paramsKey = key;
+            }
+            recorder.push(output.front(), o.width, o.height, frame / o.fps, params, paramsKey, true);
+        }
+        if (!outputDir.empty()) {
+            outPixels.setFromExternalPixels(const_cast<unsigned char*>(output.front()),
+                                            o.width, o.height, OF_PIXELS_RGB);
+            std::snprintf(name, sizeof(name), "frame_%06d.", frame);
+            ofSaveImage(outPixels, ofFilePath::join(outputDir, name + o.format));
+        }
+        auto t3 = Clock::now();
+
+        readMs  += ms(t1 - t0);
+        remapMs += ms(t2 - t1);
+        writeMs += ms(t3 - t2);
+        frame++;
+    }
+
+    double totalS = ms(Clock::now() - start) / 1000.0;
+    int    n      = std::max(frame, 1);
+    std::printf("offline: %d frames %dx%d in %.2fs (%.1f fps, %d threads)\n",
+                frame, o.width, o.height, totalS, frame / std::max(totalS, 1e-9),
+                pool.threadCount());
+    std::printf("  read+ingest %.3f ms/frame   remap %.3f ms/frame (%.2f ns/px)   write %.3f ms/frame\n",
+                readMs / n, remapMs / n, remapMs * 1e6 / ((double)n * o.width * o.height),
+                writeMs / n);
+    if (recorder.isOpen()) {
+        recorder.close();
+        if (recorder.failed) {
+            std::fprintf(stderr, "offline: %s\n", recorder.error().c_str());
+            return 1;
+        }
+        std::printf("  recorded %d frames, %.1f MB, to %s%s\n", recorder.frames.load(),
+                    recorder.bytes.load() / 1048576.0, recorder.path().c_str(), recorder.full ? " (full)" : "");
+    }
+    return frame > 0 ? 0 : 1;
+}
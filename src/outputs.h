@@ -0,0 +1,153 @@
+#pragma once
+
+#include "ofMain.h"
+#include "pipeline.h"
+#include "presets.h"
+#include "renderers.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// OutputPipeline — one named output: its own effect presets and chain,
+// double-buffered remap output and renderers. Every pipeline reads the same
+// FrameHistory, so decode, ingest and history memory do not grow with the
+// number of outputs; only output buffers and textures do.
+//
+// `viewport` is the output's share of the window in 0..1 units, e.g. one
+// projector of a desktop spanned across several.
+// ---------------------------------------------------------------------------
+struct OutputPipeline {
+    std::string     name;
+    ofRectangle     viewport = ofRectangle(0, 0, 1, 1);
+    std::string     startPreset;   // preset name to select after loading
+
+    PresetLibrary   presets;
+    int             currentPreset = 0;
+    EffectChain     chain;
+    OutputBuffers   output;
+    TextureRenderer texture;
+    AsciiRenderer   ascii;
+
+    // Drawn in this order, each reading output.front()
+    std::vector<Renderer*> renderers;
+
+    // usingLut() / usingFused() of the last published frame
+    bool baked = false;
+    bool fused = false;
+
+    OutputPipeline() { renderers = { &texture, &ascii }; }
+    OutputPipeline(const OutputPipeline&) = delete;
+    OutputPipeline& operator=(const OutputPipeline&) = delete;
+
+    void allocate(int w, int h) {
+        output.allocate(w, h);
+        texture.allocate(w, h);
+    }
+
+    void applyPreset(int index) {
+        currentPreset = (index % presets.size() + presets.size()) % presets.size();
+        chain.modules = presets[currentPreset].chain();
+    }
+
+    void publish() {
+        output.publish();
+        baked = chain.usingLut();
+        fused = chain.usingFused();
+    }
+
+    // Letterboxed rect of the given aspect inside the viewport, in pixels.
+    ofRectangle displayRect(float windowW, float windowH, float aspect) const {
+        float x = viewport.x * windowW, y = viewport.y * windowH;
+        float w = viewport.width * windowW, h = viewport.height * windowH;
+        if (w / h > aspect) return ofRectangle(x + (w - h * aspect) / 2, y, h * aspect, h);
+        return ofRectangle(x, y + (h - w / aspect) / 2, w, w / aspect);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// OutputSet — the output pipelines of one process.
+//
+// loadConfig() reads bin/data/outputs.json:
+//
+//   { "outputs": [
+//       { "name": "left",  "preset": "drift",  "viewport": [0,   0, 0.5, 1] },
+//       { "name": "right", "preset": "glitch", "viewport": [0.5, 0, 0.5, 1] } ] }
+//
+// Without the file (or with an empty list) there is one full-window output
+// named "main". Presets are filled in by the caller, per pipeline, since
+// every chain needs modules of its own.
+//
+// process() remaps every output from one RemapFrame in a single pool pass:
+// each chain plan()s on the calling thread, then the row bands of all
+// chains go to one WorkerPool::run(), so workers move on to the next
+// output's bands instead of waiting at a barrier per output.
+// ---------------------------------------------------------------------------
+struct OutputSet {
+    std::vector<std::unique_ptr<OutputPipeline>> pipelines;
+
+    int size() const { return (int)pipelines.size(); }
+
+    OutputPipeline& operator[](int i) { return *pipelines[i]; }
+
+    // Returns false (and keeps the single default output) on a bad file.
+    bool loadConfig(const std::string& path, std::string& error) {
+        pipelines.clear();
+        bool ok = true;
+        if (ofFile::doesFileExist(path)) {
+            try {
+                ofJson j = ofLoadJson(path);
+                for (auto& o : j.at("outputs")) {
+                    std::unique_ptr<OutputPipeline> p(new OutputPipeline());
+                    p->name        = o.value("name", "output " + ofToString(size() + 1));
+                    p->startPreset = o.value("preset", std::string());
+                    if (o.contains("viewport")) {
+                        const ofJson& v = o["viewport"];
+                        p->viewport.set(v.at(0).get<float>(), v.at(1).get<float>(),
+                                        v.at(2).get<float>(), v.at(3).get<float>());
+                    }
+                    pipelines.push_back(std::move(p));
+                }
+            } catch (const std::exception& e) {
+                error = path + ": " + e.what();
+                pipelines.clear();
+                ok = false;
+            }
+        }
+        if (pipelines.empty()) {
+            pipelines.emplace_back(new OutputPipeline());
+            pipelines.back()->name = "main";
+        }
+        return ok;
+    }
+
+    void allocate(int w, int h) {
+        for (auto& p : pipelines) p->allocate(w, h);
+    }
+
+    // `base` is everything but dst / feedback, which come from each
+    // pipeline's output buffers.
+    void process(const RemapFrame& base, WorkerPool& pool, bool deterministic = false) {
+        frames.assign(pipelines.size(), base);
+        firstBand.assign(pipelines.size() + 1, 0);
+        for (size_t i = 0; i < pipelines.size(); i++) {
+            OutputPipeline& p = *pipelines[i];
+            frames[i].dst      = p.output.back();
+            frames[i].feedback = p.output.front();
+            firstBand[i + 1]   = firstBand[i] + p.chain.plan(frames[i], pool, deterministic);
+        }
+        pool.run(firstBand.back(), [&](int task, int worker) {
+            size_t i = std::upper_bound(firstBand.begin(), firstBand.end(), task) - firstBand.begin() - 1;
+            pipelines[i]->chain.runBand(frames[i], task - firstBand[i], worker);
+        }, deterministic);
+    }
+
+    void publish() {
+        for (auto& p : pipelines) p->publish();
+    }
+
+private:
+    std::vector<RemapFrame> frames;
+    std::vector<int>        firstBand;   // prefix sums of bands per pipeline
+};
@@ -0,0 +1,744 @@
+#pragma once
+
+#include "effects.h"
+#include "workers.h"
+#include "history.h"
+#include "profiler.h"
+#include <cstring>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// RowScratch — per-row coordinate buffers used by EffectChain.
+// `base*` holds the channel-independent coordinates; `ch*` is the working
+// copy for the per-channel tail of the chain. Sized once, reused every row.
+// ---------------------------------------------------------------------------
+struct RowScratch {
+    std::vector<int> baseRow, baseCol, baseFrame;
+    std::vector<int> chRow, chCol, chFrame;
+
+    // Sub-pixel passes only: Q8 fractions, the four bilinear taps (plus
+    // four from the next older frame for the temporal blend) and the
+    // per-byte weights, all w*3 bytes.
+    std::vector<int> baseFracRow, baseFracCol, baseFracFrame, baseOffRow, baseOffCol;
+    std::vector<int> chFracRow,   chFracCol,   chFracFrame,   chOffRow,   chOffCol;
+    std::vector<unsigned char> taps[8], weightX, weightY, weightT;
+
+    void resize(int w) {
+        if ((int)baseRow.size() >= w) return;
+        baseRow.resize(w); baseCol.resize(w); baseFrame.resize(w);
+        chRow.resize(w);   chCol.resize(w);   chFrame.resize(w);
+    }
+
+    void resizeSubpixel(int w) {
+        if ((int)baseFracRow.size() >= w) return;
+        baseFracRow.resize(w); baseFracCol.resize(w); baseFracFrame.resize(w);
+        chFracRow.resize(w);   chFracCol.resize(w);   chFracFrame.resize(w);
+        baseOffRow.resize(w);  baseOffCol.resize(w);
+        chOffRow.resize(w);    chOffCol.resize(w);
+        for (auto& t : taps) t.resize((size_t)w * 3);
+        weightX.resize((size_t)w * 3);
+        weightY.resize((size_t)w * 3);
+        weightT.resize((size_t)w * 3);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// RemapFrame — everything one remap pass reads and writes.
+// Ages [0, numDirect) are RGB frames in frames[age] (0 = newest). Ages
+// [numDirect, numFrames) are compact frames decoded through history.
+// dst is w*h*3 RGB output. feedback is the previous output, read for
+// srcFrame == kFeedbackFrame; it must not alias dst. Null reads age 0.
+// ---------------------------------------------------------------------------
+struct RemapFrame {
+    const unsigned char* const* frames;
+    int                 numDirect;
+    int                 numFrames;
+    const FrameHistory* history;
+    unsigned char*      dst;
+    int            w, h;
+    float          time;
+    const unsigned char* feedback = nullptr;
+};
+
+// RGB frame for a source age held at full resolution (feedback or ring),
+// or nullptr when it lives in the compact tier.
+inline const unsigned char* directFrame(const RemapFrame& f, int age) {
+    if (age < 0) return f.feedback ? f.feedback : f.frames[0];
+    return age < f.numDirect ? f.frames[age] : nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// OutputBuffers — remap output frames rotated between the writer (the remap
+// pass, which fills back()) and the readers (renderers, which read front()).
+// publish() makes the finished back buffer the new front. With the remap
+// running concurrently with draw(), two buffers are enough: the remap never
+// writes the buffer being drawn. front() is also the feedback source for
+// the next remap (RemapFrame::feedback), so the ping-pong needs no copy.
+// ---------------------------------------------------------------------------
+struct OutputBuffers {
+    void allocate(int w, int h, int count = 2) {
+        buffers.assign(std::max(count, 2), std::vector<unsigned char>((size_t)w * h * 3, 0));
+        frontIndex = 0;
+    }
+
+    unsigned char*       back()        { return buffers[(frontIndex + 1) % buffers.size()].data(); }
+    const unsigned char* front() const { return buffers[frontIndex].data(); }
+
+    void publish() { frontIndex = (frontIndex + 1) % buffers.size(); }
+
+private:
+    std::vector<std::vector<unsigned char>> buffers;
+    size_t frontIndex = 0;
+};
+
+// ---------------------------------------------------------------------------
+// RemapLut — the composed mapping of a time-invariant chain, baked per
+// output pixel (or per output byte once a module uses the channel).
+// frame[] is the source frame age; 32 bits, as a memory-budgeted history
+// of small compact frames can be deeper than 64k.
+// ---------------------------------------------------------------------------
+struct RemapLut {
+    std::vector<int>      offset;   // byte offset into the source frame
+    std::vector<uint32_t> frame;
+    bool     perByte = false;
+    bool     valid   = false;
+    uint64_t key     = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Fused chain — the built-in effects compiled into one row kernel per
+// enabled set. Mask bits, in the only order the kernel handles:
+//
+//   1 Wave   2 Slitscan   4 BlockDisplace   8 RgbSplit
+//
+// fusedRows<> is instantiated for all 16 sets, so disabled effects cost
+// nothing and there is no `enabled` test, virtual call or coordinate buffer
+// per pixel: each pixel's coordinates stay in registers from the first
+// table lookup to the gather. Wraps are a conditional subtract (all table
+// shifts are normalized into [0, size)), and the Slitscan age is a single
+// per-row value. The output is identical to the generic chain with the
+// same tables.
+// ---------------------------------------------------------------------------
+struct FusedTables {
+    const int* waveColByRow  = nullptr;
+    const int* waveRowByCol  = nullptr;
+    const int* blockColByRow = nullptr;
+    const int* blockRowByCol = nullptr;
+    int slitDepth = 0, slitOldest = 0;
+    int rgbShift[3] = { 0, 0, 0 };   // per channel, in [0, w)
+};
+
+template <bool kWave, bool kSlit, bool kBlock, bool kRgb>
+void fusedRows(const RemapFrame& f, const FusedTables& t, int y0, int y1) {
+    const int w = f.w, h = f.h;
+    for (int y = y0; y < y1; y++) {
+        int age = kSlit ? std::min((y * t.slitDepth) / h, t.slitOldest) : 0;
+        const unsigned char* frame = age < f.numDirect ? f.frames[age] : nullptr;
+        unsigned char*       out   = f.dst + (size_t)y * w * 3;
+
+        for (int x = 0; x < w; x++, out += 3) {
+            int r = y, c = x;
+            if (kWave) {
+                int nc = c + t.waveColByRow[r], nr = r + t.waveRowByCol[c];
+                c = nc >= w ? nc - w : nc;
+                r = nr >= h ? nr - h : nr;
+            }
+            if (kBlock) {
+                int nc = c + t.blockColByRow[r], nr = r + t.blockRowByCol[c];
+                c = nc >= w ? nc - w : nc;
+                r = nr >= h ? nr - h : nr;
+            }
+            if (!kRgb) {
+                if (!frame) {
+                    f.history->sample(age, r, c, out);
+                    continue;
+                }
+                const unsigned char* src = frame + ((size_t)r * w + c) * 3;
+                out[0] = src[0];
+                out[1] = src[1];
+                out[2] = src[2];
+                continue;
+            }
+            for (int ch = 0; ch < 3; ch++) {
+                int cc = c + t.rgbShift[ch];
+                cc = cc >= w ? cc - w : cc;
+                out[ch] = frame ? frame[((size_t)r * w + cc) * 3 + ch]
+                                : f.history->sample(age, r, cc, ch);
+            }
+        }
+    }
+}
+
+using FusedKernel = void (*)(const RemapFrame&, const FusedTables&, int, int);
+
+template <int M>
+constexpr FusedKernel fusedKernel() {
+    return fusedRows<(M & 1) != 0, (M & 2) != 0, (M & 4) != 0, (M & 8) != 0>;
+}
+
+inline FusedKernel fusedKernelFor(int mask) {
+    static const FusedKernel kernels[16] = {
+        fusedKernel<0>(),  fusedKernel<1>(),  fusedKernel<2>(),  fusedKernel<3>(),
+        fusedKernel<4>(),  fusedKernel<5>(),  fusedKernel<6>(),  fusedKernel<7>(),
+        fusedKernel<8>(),  fusedKernel<9>(),  fusedKernel<10>(), fusedKernel<11>(),
+        fusedKernel<12>(), fusedKernel<13>(), fusedKernel<14>(), fusedKernel<15>(),
+    };
+    return kernels[mask];
+}
+
+// ---------------------------------------------------------------------------
+// EffectChain — ordered effect modules plus the remap loop that drives them.
+//
+// Rows are processed one span at a time. Modules before the first one that
+// usesChannel() run once per pixel; from there on the coordinates are copied
+// and the rest of the chain runs once per channel. The result is identical
+// to running every module per byte, as the old per-PixelContext loop did.
+//
+// process(f, pool) splits the frame into bands of kBandRows rows and runs
+// them on a WorkerPool. Every output pixel depends only on the input ring,
+// so the result does not depend on thread count or scheduling.
+//
+// When no enabled module usesTime(), the chain is baked into a RemapLut and
+// steady-state frames are a single gather. The table is rebuilt only when
+// stateKey() changes: module order, enabled flags, parameters or frame size.
+//
+// Live chains made only of the built-in effects, enabled in their canonical
+// order, run the fused kernel instead (useFused). Other modules or orders
+// fall back to the generic span loop.
+//
+// If any active module has `subpixel` on, spans also carry Q8 coordinate
+// fractions and the gather blends four taps per frame (bilinear), and two
+// frames when the age is fractional, through RemapKernels::lerpBytes. Such
+// chains always run live: no baked table, no fused kernel.
+//
+// With a Profiler attached, each module's transformRow() time is summed
+// across workers into "fx/<name>", and table rebuilds into "remap/bake".
+// The fused kernel has no per-module split; it is timed as "remap/fused".
+// ---------------------------------------------------------------------------
+struct EffectChain {
+    static const int kBandRows = 16;
+
+    std::vector<EffectModule*> modules;
+
+    // Bake time-invariant chains into `lut`.
+    bool     useLut = true;
+    RemapLut lut;
+
+    // Run live chains of built-in effects through fusedKernelFor().
+    bool useFused = true;
+
+    // Frame width that module parameters are measured at; 0 = the
+    // processing width. Each pass sets pixelScale = f.w / designWidth on
+    // the active modules, so a resolution change keeps the look.
+    int designWidth = 0;
+
+    // One scratch set per worker thread.
+    std::vector<RowScratch> scratch;
+
+    // Enabled modules in order, and the index of the first channel-dependent
+    // one. Refreshed by compile() at the start of each pass.
+    std::vector<EffectModule*> active;
+    int  channelSplit   = 0;
+    bool timeInvariant  = false;
+    bool subpixelActive = false;
+
+    void attachProfiler(Profiler* p) {
+        profiler = p;
+        stageCache.clear();
+        if (!p) return;
+        bakeStage  = p->stage("remap/bake");
+        fusedStage = p->stage("remap/fused");
+    }
+
+    void compile() {
+        active.clear();
+        activeStage.clear();
+        for (auto* m : modules) {
+            if (!m->enabled) continue;
+            active.push_back(m);
+            activeStage.push_back(stageOf(m));
+        }
+        channelSplit   = (int)active.size();
+        timeInvariant  = true;
+        subpixelActive = false;
+        for (int i = (int)active.size() - 1; i >= 0; i--) {
+            if (active[i]->usesChannel()) channelSplit  = i;
+            if (active[i]->usesTime())    timeInvariant = false;
+            if (active[i]->subpixel && active[i]->supportsSubpixel()) subpixelActive = true;
+        }
+        compileFused();
+    }
+
+    // A module's fx/<name> stage, looked up (a string build and the
+    // profiler's lock) only the first time the module runs under the
+    // attached profiler.
+    int stageOf(const EffectModule* m) {
+        if (!profiler) return -1;
+        auto it = stageCache.find(m);
+        if (it == stageCache.end()) it = stageCache.emplace(m, profiler->stage("fx/" + m->name)).first;
+        return it->second;
+    }
+
+    // Fused-kernel mask of the active set, or -1 if it has to run generic.
+    int fusedMask() const { return fused; }
+
+    // True when the last process() call ran the fused kernel.
+    bool usingFused() const { return ranFused; }
+
+    uint64_t stateKey(const RemapFrame& f) const {
+        StateHash h;
+        h << f.w << f.h << f.numFrames << designWidth;
+        for (auto* m : modules) {
+            h << m << m->enabled;
+            if (m->enabled) m->hashState(h);
+        }
+        return h.value;
+    }
+
+    // First module of type T in the chain (enabled or not), or nullptr.
+    template <typename T>
+    T* find() const {
+        for (auto* m : modules) {
+            if (auto* t = dynamic_cast<T*>(m)) return t;
+        }
+        return nullptr;
+    }
+
+    // True when the last process() call replayed the baked table.
+    bool usingLut() const { return lut.valid; }
+
+    // Full frame on the calling thread.
+    void process(const RemapFrame& f) {
+        process(f, serialPool);
+    }
+
+    // Full frame split into row bands across the pool.
+    void process(const RemapFrame& f, WorkerPool& pool, bool deterministic = false) {
+        int numBands = plan(f, pool, deterministic);
+        ProfileScope scope(ranFused ? profiler : nullptr, fusedStage);
+        pool.run(numBands, [&](int band, int worker) { runBand(f, band, worker); }, deterministic);
+    }
+
+    // process() in two halves, so several chains can share one pool.run():
+    // plan() does the per-frame work on the calling thread (compile,
+    // beginFrame, a table bake when due) and returns the number of bands;
+    // runBand() then fills one band and may run concurrently for different
+    // bands, one worker index per thread.
+    int plan(const RemapFrame& f, WorkerPool& pool, bool deterministic = false) {
+        compile();
+        float scale = designWidth > 0 ? (float)f.w / designWidth : 1.0f;
+        for (auto* m : active) m->pixelScale = scale;
+        if ((int)scratch.size() < pool.threadCount()) scratch.resize(pool.threadCount());
+
+        ranFused = false;
+        if (!useLut || !timeInvariant || subpixelActive) {
+            lut.valid = false;
+            for (auto* m : active) m->beginFrame(f.time, f.w, f.h);
+            if (useFused && fused >= 0) {
+                passTables = fusedTables(f);
+                passKernel = fusedKernelFor(fused);
+                ranFused   = true;
+            }
+        } else {
+            uint64_t key = stateKey(f);
+            if (!lut.valid || lut.key != key) {
+                bakeLut(f, pool, deterministic);
+                lut.key = key;
+            }
+        }
+        return (f.h + kBandRows - 1) / kBandRows;
+    }
+
+    void runBand(const RemapFrame& f, int band, int worker) {
+        int y0 = band * kBandRows, y1 = std::min(y0 + kBandRows, f.h);
+        if (ranFused)       passKernel(f, passTables, y0, y1);
+        else if (lut.valid) gatherLut(f, y0, y1);
+        else                processRows(f, y0, y1, scratch[worker], nullptr);
+    }
+
+    // Rows [y0, y1). compile() and beginFrame() must have run for this frame.
+    // With `bake` set, coordinates go into the table instead of f.dst.
+    void processRows(const RemapFrame& f, int y0, int y1, RowScratch& s, RemapLut* bake) {
+        s.resize(f.w);
+        if (subpixelActive) s.resizeSubpixel(f.w);
+        for (int y = y0; y < y1; y++) {
+            processSpan(f, y, 0, f.w, s, bake);
+        }
+    }
+
+    void processSpan(const RemapFrame& f, int y, int x0, int count, RowScratch& s,
+                     RemapLut* bake) {
+        for (int i = 0; i < count; i++) {
+            s.baseRow[i]   = y;
+            s.baseCol[i]   = x0 + i;
+            s.baseFrame[i] = 0;
+        }
+
+        RowSpan span = { y, x0, count, -1,
+                         s.baseRow.data(), s.baseCol.data(), s.baseFrame.data(),
+                         f.time, f.w, f.h };
+        if (subpixelActive) {
+            std::fill(s.baseFracRow.begin(),   s.baseFracRow.begin()   + count, 0);
+            std::fill(s.baseFracCol.begin(),   s.baseFracCol.begin()   + count, 0);
+            std::fill(s.baseFracFrame.begin(), s.baseFracFrame.begin() + count, 0);
+            std::fill(s.baseOffRow.begin(),    s.baseOffRow.begin()    + count, 0);
+            std::fill(s.baseOffCol.begin(),    s.baseOffCol.begin()    + count, 0);
+            span.fracRow     = s.baseFracRow.data();
+            span.fracCol     = s.baseFracCol.data();
+            span.fracFrame   = s.baseFracFrame.data();
+            span.inputOffRow = s.baseOffRow.data();
+            span.inputOffCol = s.baseOffCol.data();
+        }
+        for (int m = 0; m < channelSplit; m++) runModule(m, span);
+
+        size_t pixel0 = (size_t)y * f.w + x0;
+        unsigned char* out = bake ? nullptr : f.dst + pixel0 * 3;
+
+        // No channel-dependent modules: one lookup gathers all three bytes.
+        if (channelSplit == (int)active.size() && subpixelActive) {
+            gatherSubpixel(f, span, -1, out, s);
+            return;
+        }
+        if (channelSplit == (int)active.size()) {
+            if (bake) {
+                for (int i = 0; i < count; i++) {
+                    bake->offset[pixel0 + i] = (s.baseRow[i] * f.w + s.baseCol[i]) * 3;
+                    bake->frame[pixel0 + i]  = (uint32_t)s.baseFrame[i];
+                }
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                int age = s.baseFrame[i];
+                const unsigned char* src;
+                if ((unsigned)age < (unsigned)f.numDirect) {
+                    src = f.frames[age];
+                } else if (age < 0) {
+                    src = directFrame(f, age);
+                } else {
+                    f.history->sample(age, s.baseRow[i], s.baseCol[i], out + i * 3);
+                    continue;
+                }
+                src += ((size_t)s.baseRow[i] * f.w + s.baseCol[i]) * 3;
+                out[i * 3 + 0] = src[0];
+                out[i * 3 + 1] = src[1];
+                out[i * 3 + 2] = src[2];
+            }
+            return;
+        }
+
+        for (int ch = 0; ch < 3; ch++) {
+            std::copy(s.baseRow.begin(),   s.baseRow.begin()   + count, s.chRow.begin());
+            std::copy(s.baseCol.begin(),   s.baseCol.begin()   + count, s.chCol.begin());
+            std::copy(s.baseFrame.begin(), s.baseFrame.begin() + count, s.chFrame.begin());
+
+            RowSpan chSpan = { y, x0, count, ch,
+                               s.chRow.data(), s.chCol.data(), s.chFrame.data(),
+                               f.time, f.w, f.h };
+            if (subpixelActive) {
+                std::copy(s.baseFracRow.begin(),   s.baseFracRow.begin()   + count, s.chFracRow.begin());
+                std::copy(s.baseFracCol.begin(),   s.baseFracCol.begin()   + count, s.chFracCol.begin());
+                std::copy(s.baseFracFrame.begin(), s.baseFracFrame.begin() + count, s.chFracFrame.begin());
+                std::copy(s.baseOffRow.begin(),    s.baseOffRow.begin()    + count, s.chOffRow.begin());
+                std::copy(s.baseOffCol.begin(),    s.baseOffCol.begin()    + count, s.chOffCol.begin());
+                chSpan.fracRow     = s.chFracRow.data();
+                chSpan.fracCol     = s.chFracCol.data();
+                chSpan.fracFrame   = s.chFracFrame.data();
+                chSpan.inputOffRow = s.chOffRow.data();
+                chSpan.inputOffCol = s.chOffCol.data();
+            }
+            for (int m = channelSplit; m < (int)active.size(); m++) runModule(m, chSpan);
+
+            if (subpixelActive) {
+                gatherSubpixel(f, chSpan, ch, out, s);
+                continue;
+            }
+
+            if (bake) {
+                for (int i = 0; i < count; i++) {
+                    size_t b = (pixel0 + i) * 3 + ch;
+                    bake->offset[b] = (s.chRow[i] * f.w + s.chCol[i]) * 3 + ch;
+                    bake->frame[b]  = (uint32_t)s.chFrame[i];
+                }
+                continue;
+            }
+            for (int i = 0; i < count; i++) {
+                int age = s.chFrame[i];
+                out[i * 3 + ch] = (unsigned)age < (unsigned)f.numDirect
+                    ? f.frames[age][((size_t)s.chRow[i] * f.w + s.chCol[i]) * 3 + ch]
+                    : fetch(f, age, s.chRow[i], s.chCol[i], ch);
+            }
+        }
+    }
+
+private:
+    WorkerPool serialPool;
+
+    Profiler*        profiler   = nullptr;
+    int              bakeStage  = -1;
+    int              fusedStage = -1;
+    std::vector<int> activeStage;   // profiler stage per active module
+    std::unordered_map<const EffectModule*, int> stageCache;   // see stageOf()
+
+    int  fused    = -1;
+    bool ranFused = false;
+
+    // The fused pass set up by plan()
+    FusedTables passTables;
+    FusedKernel passKernel = nullptr;
+
+    // Built-in effect i of the fused order, or -1. Exact types only: a
+    // subclass may override transformRow().
+    static int fusedIndex(const EffectModule* m) {
+        const std::type_info& t = typeid(*m);
+        if (t == typeid(WaveEffect))          return 0;
+        if (t == typeid(SlitscanEffect))      return 1;
+        if (t == typeid(BlockDisplaceEffect)) return 2;
+        if (t == typeid(RgbSplitEffect))      return 3;
+        return -1;
+    }
+
+    void compileFused() {
+        fused = -1;
+        if (subpixelActive) return;
+        fused = 0;
+        int last = -1;
+        for (auto* m : active) {
+            int i = fusedIndex(m);
+            if (i <= last) {
+                fused = -1;
+                return;
+            }
+            fused |= 1 << i;
+            last = i;
+        }
+    }
+
+    // Tables of the active built-ins; beginFrame() must have run.
+    FusedTables fusedTables(const RemapFrame& f) const {
+        FusedTables t;
+        for (auto* m : active) {
+            switch (fusedIndex(m)) {
+                case 0: {
+                    auto* e = static_cast<WaveEffect*>(m);
+                    t.waveColByRow = e->colShiftByRow.data();
+                    t.waveRowByCol = e->rowShiftByCol.data();
+                    break;
+                }
+                case 1: {
+                    auto* e = static_cast<SlitscanEffect*>(m);
+                    t.slitDepth  = e->depth;
+                    t.slitOldest = e->numFrames - 1;
+                    break;
+                }
+                case 2: {
+                    auto* e = static_cast<BlockDisplaceEffect*>(m);
+                    t.blockColByRow = e->colShiftByRow.data();
+                    t.blockRowByCol = e->rowShiftByCol.data();
+                    break;
+                }
+                case 3: {
+                    auto* e = static_cast<RgbSplitEffect*>(m);
+                    t.rgbShift[0] = normalizeShift(-e->shiftPixels(), f.w);
+                    t.rgbShift[2] = normalizeShift(e->shiftPixels(), f.w);
+                    break;
+                }
+            }
+        }
+        return t;
+    }
+
+    void runModule(int m, RowSpan& span) {
+        if (!profiler || !profiler->enabled) {
+            active[m]->transformRow(span);
+            return;
+        }
+        int64_t t0 = Profiler::now();
+        active[m]->transformRow(span);
+        profiler->add(activeStage[m], t0, Profiler::now(), false);
+    }
+
+    void bakeLut(const RemapFrame& f, WorkerPool& pool, bool deterministic) {
+        ProfileScope scope(profiler, bakeStage);
+        lut.perByte = channelSplit != (int)active.size();
+        size_t n = (size_t)f.w * f.h * (lut.perByte ? 3 : 1);
+        lut.offset.resize(n);
+        lut.frame.resize(n);
+
+        for (auto* m : active) m->beginFrame(f.time, f.w, f.h);
+
+        int numBands = (f.h + kBandRows - 1) / kBandRows;
+        pool.run(numBands, [&](int band, int worker) {
+            int y0 = band * kBandRows;
+            processRows(f, y0, std::min(y0 + kBandRows, f.h), scratch[worker], &lut);
+        }, deterministic);
+        lut.valid = true;
+    }
+
+    // One byte of the frame at `age`, from the feedback buffer, the ring or
+    // the compact tier.
+    static unsigned char fetch(const RemapFrame& f, int age, int r, int c, int ch) {
+        const unsigned char* frame = directFrame(f, age);
+        return frame ? frame[((size_t)r * f.w + c) * 3 + ch]
+                     : f.history->sample(age, r, c, ch);
+    }
+
+    static unsigned char lerp8(int a, int b, int t) {
+        return (unsigned char)((a * (256 - t) + b * t + 128) >> 8);
+    }
+
+    // The newest input, bilinear at the Q8 position (rq, cq) (any integers;
+    // wrapped into the frame), written to all four taps of pixel i so the
+    // temporal blend mixes it in whole before the feedback's own bilinear.
+    static void gatherInputTap(const RemapFrame& f, int rq, int cq, int c0, int nb,
+                               unsigned char* const* t, int i) {
+        const int mask = (1 << kSubpixelBits) - 1;
+        rq = normalizeShift(rq, f.h << kSubpixelBits);
+        cq = normalizeShift(cq, f.w << kSubpixelBits);
+        int r = rq >> kSubpixelBits, c = cq >> kSubpixelBits;
+        int r1 = r + 1 == f.h ? 0 : r + 1;
+        int c1 = c + 1 == f.w ? 0 : c + 1;
+        for (int k = 0; k < nb; k++) {
+            int top    = lerp8(fetch(f, 0, r,  c, c0 + k), fetch(f, 0, r,  c1, c0 + k), cq & mask);
+            int bottom = lerp8(fetch(f, 0, r1, c, c0 + k), fetch(f, 0, r1, c1, c0 + k), cq & mask);
+            unsigned char v = lerp8(top, bottom, rq & mask);
+            t[0][i * nb + k] = t[1][i * nb + k] = t[2][i * nb + k] = t[3][i * nb + k] = v;
+        }
+    }
+
+    // Gathers the four neighbours of every span coordinate in frame
+    // `age + ageStep` into taps[t0 .. t0+3], `nb` bytes per pixel starting at
+    // channel c0, or just the sample itself into taps[t0] when !bilinear.
+    // Neighbours wrap like every other coordinate in the chain. The temporal
+    // partner of a feedback sample is the input; see RowSpan.
+    static void gatherTaps(const RemapFrame& f, const RowSpan& span, int ageStep,
+                           int c0, int nb, RowScratch& s, int t0, bool bilinear) {
+        unsigned char* t[4] = { s.taps[t0].data(),     s.taps[t0 + 1].data(),
+                                s.taps[t0 + 2].data(), s.taps[t0 + 3].data() };
+        const int oldest = f.numFrames - 1;
+        for (int i = 0; i < span.count; i++) {
+            if (ageStep > 0 && span.srcFrame[i] < 0) {
+                gatherInputTap(f, (span.srcRow[i] << kSubpixelBits) + span.fracRow[i] + span.inputOffRow[i],
+                                  (span.srcCol[i] << kSubpixelBits) + span.fracCol[i] + span.inputOffCol[i],
+                               c0, nb, t, i);
+                continue;
+            }
+            int age = std::min(span.srcFrame[i] + ageStep, oldest);
+            int r = span.srcRow[i], c = span.srcCol[i];
+            int r1 = r + 1 == f.h ? 0 : r + 1;
+            int c1 = c + 1 == f.w ? 0 : c + 1;
+            const unsigned char* frame = directFrame(f, age);
+            if (!bilinear) {
+                if (frame && nb == 3) {
+                    const unsigned char* p = frame + ((size_t)r * f.w + c) * 3;
+                    unsigned char* d = t[0] + i * 3;
+                    d[0] = p[0]; d[1] = p[1]; d[2] = p[2];
+                    continue;
+                }
+                for (int k = 0; k < nb; k++) t[0][i * nb + k] = fetch(f, age, r, c, c0 + k);
+                continue;
+            }
+            if (frame && nb == 3) {
+                const unsigned char* p00 = frame + ((size_t)r * f.w + c) * 3;
+                const unsigned char* p01 = p00 + (c1 - c) * 3;
+                const unsigned char* p10 = p00 + (ptrdiff_t)(r1 - r) * f.w * 3;
+                const unsigned char* p11 = p10 + (c1 - c) * 3;
+                unsigned char* d = t[0] + i * 3;
+                d[0] = p00[0]; d[1] = p00[1]; d[2] = p00[2];
+                d = t[1] + i * 3;
+                d[0] = p01[0]; d[1] = p01[1]; d[2] = p01[2];
+                d = t[2] + i * 3;
+                d[0] = p10[0]; d[1] = p10[1]; d[2] = p10[2];
+                d = t[3] + i * 3;
+                d[0] = p11[0]; d[1] = p11[1]; d[2] = p11[2];
+                continue;
+            }
+            for (int k = 0; k < nb; k++) {
+                t[0][i * nb + k] = fetch(f, age, r,  c,  c0 + k);
+                t[1][i * nb + k] = fetch(f, age, r,  c1, c0 + k);
+                t[2][i * nb + k] = fetch(f, age, r1, c,  c0 + k);
+                t[3][i * nb + k] = fetch(f, age, r1, c1, c0 + k);
+            }
+        }
+    }
+
+    // Bilinear (and, with fractional ages, temporal) gather of a span into
+    // out: all three bytes per pixel for ch == -1, else channel ch only.
+    // Spans whose row and column fractions are all zero (whole-pixel moves,
+    // or only a temporal blend) gather one tap per frame and skip the
+    // bilinear lerps, which would leave those taps unchanged.
+    void gatherSubpixel(const RemapFrame& f, const RowSpan& span, int ch,
+                        unsigned char* out, RowScratch& s) {
+        const int nb = ch < 0 ? 3 : 1, c0 = std::max(ch, 0);
+        const int n  = span.count * nb;
+        bool temporal = false, spatial = false;
+        for (int i = 0; i < span.count; i++) {
+            for (int k = 0; k < nb; k++) {
+                s.weightX[i * nb + k] = (unsigned char)span.fracCol[i];
+                s.weightY[i * nb + k] = (unsigned char)span.fracRow[i];
+                s.weightT[i * nb + k] = (unsigned char)span.fracFrame[i];
+            }
+            temporal |= span.fracFrame[i] != 0;
+            spatial  |= (span.fracRow[i] | span.fracCol[i]) != 0;
+        }
+
+        const RemapKernels& k = remapKernels();
+        gatherTaps(f, span, 0, c0, nb, s, 0, spatial);
+        if (temporal) gatherTaps(f, span, 1, c0, nb, s, 4, spatial);
+        if (!spatial) {
+            unsigned char* t0 = s.taps[0].data();
+            if (temporal)    k.lerpBytes(t0, s.taps[4].data(), s.weightT.data(), ch < 0 ? out : t0, n);
+            else if (ch < 0) std::memcpy(out, t0, n);
+            if (ch >= 0) for (int i = 0; i < span.count; i++) out[i * 3 + ch] = t0[i];
+            return;
+        }
+        if (temporal) {
+            for (int t = 0; t < 4; t++) {
+                k.lerpBytes(s.taps[t].data(), s.taps[t + 4].data(), s.weightT.data(), s.taps[t].data(), n);
+            }
+        }
+        k.lerpBytes(s.taps[0].data(), s.taps[1].data(), s.weightX.data(), s.taps[0].data(), n);
+        k.lerpBytes(s.taps[2].data(), s.taps[3].data(), s.weightX.data(), s.taps[2].data(), n);
+        if (ch < 0) {
+            k.lerpBytes(s.taps[0].data(), s.taps[2].data(), s.weightY.data(), out, n);
+            return;
+        }
+        k.lerpBytes(s.taps[0].data(), s.taps[2].data(), s.weightY.data(), s.taps[1].data(), n);
+        for (int i = 0; i < span.count; i++) out[i * 3 + ch] = s.taps[1][i];
+    }
+
+    static unsigned char sampleOlder(const RemapFrame& f, int age, int offset) {
+        int p = offset / 3;
+        return f.history->sample(age, p / f.w, p % f.w, offset % 3);
+    }
+
+    void gatherLut(const RemapFrame& f, int y0, int y1) {
+        const int per = lut.perByte ? 3 : 1;
+        size_t i0 = (size_t)y0 * f.w * per;
+        size_t i1 = (size_t)y1 * f.w * per;
+        const int*      off = lut.offset.data();
+        const uint32_t* age = lut.frame.data();
+
+        const uint32_t numDirect = (uint32_t)f.numDirect;
+
+        if (lut.perByte) {
+            for (size_t i = i0; i < i1; i++) {
+                f.dst[i] = age[i] < numDirect ? f.frames[age[i]][off[i]]
+                                              : sampleOlder(f, (int)age[i], off[i]);
+            }
+            return;
+        }
+        for (size_t i = i0; i < i1; i++) {
+            if (age[i] >= numDirect) {
+                int p = off[i] / 3;
+                f.history->sample((int)age[i], p / f.w, p % f.w, f.dst + i * 3);
+                continue;
+            }
+            const unsigned char* src = f.frames[age[i]] + off[i];
+            f.dst[i * 3 + 0] = src[0];
+            f.dst[i * 3 + 1] = src[1];
+            f.dst[i * 3 + 2] = src[2];
+        }
+    }
+};
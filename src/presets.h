@@ -0,0 +1,157 @@
+#pragma once
+
+#include "ofMain.h"
+#include "effects.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// EffectPreset — a named effect graph: module order (duplicates allowed),
+// enabled flags and parameters. Stored as JSON:
+//
+//   { "name": "glitch",
+//     "effects": [
+//       { "type": "wave", "params": { "hAmount": 2.5, "subpixel": true } },
+//       { "type": "rgbsplit", "enabled": false, "params": { "shiftAmount": 4 } }
+//     ] }
+//
+// "type" is an EffectRegistry key; "enabled" defaults to true. An unknown
+// type or parameter fails the load with a message naming it, so a typo
+// never drops a module silently.
+//
+// A preset owns its modules, created once at load. Switching presets only
+// swaps the chain's module list; parsing and allocation never happen
+// during a show.
+// ---------------------------------------------------------------------------
+struct EffectPreset {
+    std::string name;
+    std::vector<std::unique_ptr<EffectModule>> modules;
+
+    // The module list to hand to EffectChain::modules.
+    std::vector<EffectModule*> chain() const {
+        std::vector<EffectModule*> c;
+        for (auto& m : modules) c.push_back(m.get());
+        return c;
+    }
+
+    void add(EffectModule* m, bool enabled) {
+        m->enabled = enabled;
+        modules.emplace_back(m);
+    }
+
+    bool fromJson(const ofJson& j, std::string& error) {
+        modules.clear();
+        if (!j.is_object() || !j.contains("effects") || !j["effects"].is_array()) {
+            error = "missing \"effects\" array";
+            return false;
+        }
+        name = j.value("name", std::string("untitled"));
+        for (auto& e : j["effects"]) {
+            std::string type = e.is_object() ? e.value("type", std::string()) : std::string();
+            EffectModule* m = makeEffect(type);
+            if (!m) {
+                error = "unknown effect type '" + type + "'";
+                return false;
+            }
+            add(m, e.value("enabled", true));
+            if (!e.contains("params")) continue;
+            for (auto& p : e["params"].items()) {
+                const ofJson& v = p.value();
+                float value = v.is_boolean() ? (v.get<bool>() ? 1.0f : 0.0f)
+                            : v.is_number()  ? v.get<float>() : NAN;
+                if (std::isnan(value) || !m->setParam(p.key(), value)) {
+                    error = "cannot set " + type + "." + p.key();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static ofJson toJson(const std::string& name, const std::vector<EffectModule*>& chain) {
+        ofJson j;
+        j["name"]    = name;
+        j["effects"] = ofJson::array();
+        for (auto* m : chain) {
+            ofJson e, params = ofJson::object();
+            e["type"]    = m->type;
+            e["enabled"] = m->enabled;
+            for (auto& p : m->params()) {
+                if      (p.b) params[p.name] = *p.b;
+                else if (p.i) params[p.name] = *p.i;
+                else          params[p.name] = *p.f;
+            }
+            e["params"] = params;
+            j["effects"].push_back(e);
+        }
+        return j;
+    }
+
+    // Hash of everything toJson() writes, to tell whether the JSON changed
+    // without building it.
+    static uint64_t paramsKey(const std::string& name, const std::vector<EffectModule*>& chain) {
+        StateHash h;
+        h.add(name.data(), name.size());
+        for (auto* m : chain) {
+            h.add(m->type.data(), m->type.size());
+            h << m->enabled;
+            for (auto& p : m->params()) h << p.get();
+        }
+        return h.value;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// PresetLibrary — every *.json preset in a folder, sorted by file name.
+// Files that fail to parse are skipped and reported in `errors`.
+// ---------------------------------------------------------------------------
+struct PresetLibrary {
+    std::vector<std::unique_ptr<EffectPreset>> presets;
+    std::vector<std::string>                   errors;
+
+    int size() const { return (int)presets.size(); }
+
+    EffectPreset& operator[](int i) { return *presets[i]; }
+
+    // Index of the first preset called `name`, or -1.
+    int find(const std::string& name) const {
+        for (int i = 0; i < size(); i++) {
+            if (presets[i]->name == name) return i;
+        }
+        return -1;
+    }
+
+    // Appends the presets found in `dir`; returns how many loaded.
+    int loadFolder(const std::string& dir) {
+        ofDirectory folder(dir);
+        if (!folder.exists()) return 0;
+        folder.allowExt("json");
+        folder.listDir();
+        folder.sort();
+        int loaded = 0;
+        for (size_t i = 0; i < folder.size(); i++) {
+            if (loadFile(folder.getPath(i))) loaded++;
+        }
+        return loaded;
+    }
+
+    bool loadFile(const std::string& path) {
+        std::unique_ptr<EffectPreset> p(new EffectPreset());
+        std::string error;
+        bool ok = false;
+        try {
+            ok = p->fromJson(ofLoadJson(path), error);
+        } catch (const std::exception& e) {
+            error = e.what();   // wrongly typed JSON values
+        }
+        if (!ok) {
+            errors.push_back(path + ": " + error);
+            return false;
+        }
+        presets.push_back(std::move(p));
+        return true;
+    }
+
+    void add(std::unique_ptr<EffectPreset> p) { presets.push_back(std::move(p)); }
+};
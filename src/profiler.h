@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Profiler — per-stage frame timing with rolling percentiles and an
+// optional Chrome trace (chrome://tracing, Perfetto).
+//
+// Stages are registered by name from any thread (stage() returns a stable
+// id; up to kMaxStages). Time spent in a stage is summed over the frame from any
+// thread, so a stage run on N workers reports CPU time, not wall time.
+// endFrame() pushes each stage that ran into a window of kWindow frames;
+// p50()/p99() read from that window.
+//
+// Disabled cost: ProfileScope checks `enabled` once and does nothing else.
+// Trace events are kept only while `tracing` is set and only for scopes
+// (not for per-row module timing, which would be thousands per frame).
+// ---------------------------------------------------------------------------
+struct Profiler {
+    static const int    kWindow    = 120;
+    static const int    kMaxStages = 64;
+    static const size_t kMaxEvents = 1 << 20;
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> tracing{false};
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Finds or registers a stage. Past kMaxStages, new names share the last id.
+    int stage(const std::string& name) {
+        std::lock_guard<std::mutex> lock(stageMutex);
+        int n = numStages();
+        for (int i = 0; i < n; i++) {
+            if (stages[i]->name == name) return i;
+        }
+        if (n == kMaxStages) return n - 1;
+        stages[n].reset(new Stage(name));
+        count.store(n + 1, std::memory_order_release);
+        return n;
+    }
+
+    int                numStages()       const { return count.load(std::memory_order_acquire); }
+    const std::string& stageName(int s)  const { return stages[s]->name; }
+    bool               hasSamples(int s) const { return stages[s]->count > 0; }
+
+    // Adds [start, end) to a stage; any thread.
+    void add(int s, int64_t start, int64_t end, bool trace = true) {
+        Stage& st = *stages[s];
+        st.frameNs += end - start;
+        st.frameCalls++;
+        if (trace && tracing) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            if (events.size() < kMaxEvents) events.push_back({ s, start, end - start, threadIndex() });
+        }
+    }
+
+    void endFrame() {
+        for (int s = 0; s < numStages(); s++) {
+            Stage* st = stages[s].get();
+            if (st->frameCalls.exchange(0) == 0) continue;
+            st->window[st->next] = (float)(st->frameNs.exchange(0) * 1e-6);   // ms
+            st->next  = (st->next + 1) % kWindow;
+            st->count = std::min(st->count + 1, kWindow);
+        }
+    }
+
+    float p50(int s) const { return percentile(s, 0.50f); }
+    float p99(int s) const { return percentile(s, 0.99f); }
+
+    void startTrace() {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        events.clear();
+        tracing = true;
+    }
+
+    // Stops tracing and writes the collected events as Chrome trace JSON.
+    bool writeTrace(const std::string& path) {
+        tracing = false;
+        std::lock_guard<std::mutex> lock(traceMutex);
+        FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) return false;
+        std::fprintf(f, "{\"traceEvents\":[\n");
+        for (size_t i = 0; i < events.size(); i++) {
+            const Event& e = events[i];
+            std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}\n",
+                         i ? "," : "", stages[e.stage]->name.c_str(),
+                         e.start * 1e-3, e.dur * 1e-3, e.tid);
+        }
+        std::fprintf(f, "]}\n");
+        std::fclose(f);
+        events.clear();
+        return true;
+    }
+
+private:
+    struct Stage {
+        std::string          name;
+        std::atomic<int64_t> frameNs{0};
+        std::atomic<int>     frameCalls{0};
+        float                window[kWindow] = {};
+        int                  next  = 0;
+        int                  count = 0;
+        explicit Stage(const std::string& n) : name(n) {}
+    };
+
+    struct Event {
+        int     stage;
+        int64_t start, dur;
+        int     tid;
+    };
+
+    std::unique_ptr<Stage> stages[kMaxStages];
+    std::atomic<int>       count{0};
+    std::mutex             stageMutex;
+    std::vector<Event>     events;
+    std::mutex             traceMutex;
+
+    static int threadIndex() {
+        static std::atomic<int> counter{0};
+        thread_local int index = counter++;
+        return index;
+    }
+
+    float percentile(int s, float q) const {
+        const Stage& st = *stages[s];
+        if (st.count == 0) return 0.0f;
+        float sorted[kWindow];
+        std::copy(st.window, st.window + st.count, sorted);
+        int k = std::min(st.count - 1, (int)(q * st.count));
+        std::nth_element(sorted, sorted + k, sorted + st.count);
+        return sorted[k];
+    }
+};
+
+// ---------------------------------------------------------------------------
+// ProfileScope — times the enclosing block into a Profiler stage. A null
+// profiler (nothing attached) is allowed and costs the same as a disabled one.
+// ---------------------------------------------------------------------------
+struct ProfileScope {
+    Profiler* profiler;
+    int       stage;
+    int64_t   start = 0;
+
+    ProfileScope(Profiler* p, int s) : profiler(p && p->enabled ? p : nullptr), stage(s) {
+        if (profiler) start = Profiler::now();
+    }
+    ProfileScope(Profiler& p, int s) : ProfileScope(&p, s) {}
+    ~ProfileScope() {
+        if (profiler) profiler->add(stage, start, Profiler::now());
+    }
+};
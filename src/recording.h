@@ -0,0 +1,556 @@
+#pragma once
+
+#include "ofMain.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Recording file (.ofxr) — processed output frames with their effect time
+// and effect parameters, for frame-exact review and build-to-build
+// comparison.
+//
+//   RecordingHeader            64 bytes
+//   RecordingEntry[capacity]   32 bytes per frame, in frame order
+//   frame data                 per frame: params JSON (when changed), payload
+//
+// The file is preallocated to its full size and written through a shared
+// mapping; closing truncates it after the last frame. `count` is stored
+// last, with release ordering, so a reader mapping a file that is still
+// being recorded only ever sees whole frames.
+//
+// Payload codecs (lossless):
+//   Raw    w*h*3 RGB bytes
+//   Delta  against the frame before: varint count of unchanged bytes,
+//          varint count of literal bytes, the literals; repeated to w*h*3
+// A Raw key frame starts every keyInterval frames, on size changes and
+// whenever Delta would not be smaller, so a seek decodes at most
+// keyInterval - 1 deltas.
+// ---------------------------------------------------------------------------
+struct RecordingHeader {
+    static constexpr uint32_t kVersion = 1;
+
+    char     magic[4];      // "OXFR"
+    uint32_t version;
+    uint32_t capacity;      // index entries
+    uint32_t keyInterval;
+    uint64_t dataStart;     // first byte after the index
+    uint64_t dataEnd;       // first free byte
+    uint32_t count;         // committed frames
+    uint32_t reserved;
+    char     output[24];    // output pipeline name, 0-terminated
+};
+
+struct RecordingEntry {
+    enum Codec : uint8_t { Raw, Delta };
+
+    uint64_t offset;        // params JSON, then payload
+    uint32_t bytes;         // payload
+    uint32_t paramsBytes;   // 0 = same params as the frame before
+    double   time;          // effect time, seconds
+    uint16_t width;
+    uint16_t height;
+    uint8_t  codec;
+    uint8_t  pad[3];
+};
+
+static_assert(sizeof(RecordingHeader) == 64, "recording header layout");
+static_assert(sizeof(RecordingEntry)  == 32, "recording entry layout");
+
+// Encodes `cur` against `prev` (n bytes each) into out[0..limit). Returns
+// the encoded size, or 0 when it does not fit (store the frame Raw).
+// Unchanged runs shorter than kMinRun stay inside the literal run, where
+// they cost less than a new token.
+inline size_t encodeDelta(const unsigned char* prev, const unsigned char* cur, size_t n,
+                          unsigned char* out, size_t limit) {
+    const size_t kMinRun = 8;
+    size_t o = 0, i = 0;
+    auto put = [&](size_t v) {
+        for (; v >= 0x80; v >>= 7) {
+            if (o >= limit) return false;
+            out[o++] = (unsigned char)(v | 0x80);
+        }
+        if (o >= limit) return false;
+        out[o++] = (unsigned char)v;
+        return true;
+    };
+    auto sameWord = [&](size_t j) {
+        uint64_t a, b;
+        std::memcpy(&a, prev + j, 8);
+        std::memcpy(&b, cur + j, 8);
+        return a == b;
+    };
+    while (i < n) {
+        size_t same = i;
+        while (same + 8 <= n && sameWord(same)) same += 8;
+        while (same < n && prev[same] == cur[same]) same++;
+
+        size_t lit = same;
+        while (lit < n) {
+            if (prev[lit] == cur[lit] && (lit + kMinRun > n || sameWord(lit))) break;
+            lit++;
+        }
+        if (!put(same - i) || !put(lit - same) || lit - same > limit - o) return 0;
+        std::memcpy(out + o, cur + same, lit - same);
+        o += lit - same;
+        i  = lit;
+    }
+    return o;
+}
+
+// Applies a Delta payload to `frame`, which holds the frame before.
+// Returns false on a malformed payload.
+inline bool decodeDelta(const unsigned char* in, size_t bytes, unsigned char* frame, size_t n) {
+    size_t i = 0, o = 0;
+    auto get = [&](size_t& v) {
+        v = 0;
+        for (int shift = 0; i < bytes && shift < 64; shift += 7) {
+            unsigned char b = in[i++];
+            v |= (size_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    };
+    while (o < n) {
+        size_t skip, lit;
+        if (!get(skip) || !get(lit) || skip > n - o || lit > n - o - skip || lit > bytes - i) return false;
+        o += skip;
+        std::memcpy(frame + o, in + i, lit);
+        o += lit;
+        i += lit;
+    }
+    return i == bytes;
+}
+
+// Reserves real blocks, so a full disk fails here rather than as SIGBUS on
+// a page of the mapping mid-recording.
+inline bool preallocateFile(int fd, size_t size) {
+#if defined(__APPLE__)
+    fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)size, 0 };
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(fd, F_PREALLOCATE, &store) == -1) return false;
+    }
+    return ftruncate(fd, (off_t)size) == 0;
+#elif defined(__linux__)
+    return posix_fallocate(fd, 0, (off_t)size) == 0;
+#else
+    return ftruncate(fd, (off_t)size) == 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// FrameRecorder — appends frames to a .ofxr file on its own writer thread.
+//
+// push() copies the frame into one of kQueueFrames preallocated slots (a
+// single-producer / single-consumer ring like FrameQueue) and returns; a
+// full ring drops the frame and counts it in `dropped`, so update() never
+// waits on the disk. The writer thread creates and preallocates the file,
+// delta-encodes straight into the mapping and commits each frame.
+//
+// Params are stored only when their key (EffectPreset::paramsKey()) differs
+// from the frame before, so push() never compares the JSON. Once the file
+// or its index is full, `full` is set and further frames are ignored.
+// ---------------------------------------------------------------------------
+struct FrameRecorder {
+    static const int kQueueFrames = 8;
+
+    size_t   budgetBytes = (size_t)4096 << 20;   // file size while recording
+    uint32_t maxFrames   = 216000;               // index entries: 1h at 60 fps
+    uint32_t keyInterval = 30;
+
+    std::atomic<int>      frames{0};    // committed to the file
+    std::atomic<int>      dropped{0};   // lost to a full queue
+    std::atomic<uint64_t> bytes{0};     // file bytes in use
+    std::atomic<bool>     full{false};
+    std::atomic<bool>     failed{false};
+
+    FrameRecorder() : queue(kQueueFrames + 1) {}
+    ~FrameRecorder() { close(); }
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    bool isOpen() const { return thread.joinable(); }
+    const std::string& path() const { return filePath; }
+
+    // Valid once `failed` is set.
+    const std::string& error() const { return errorText; }
+
+    // Starts a new file at `path`; `output` names the recorded pipeline.
+    void open(const std::string& path, const std::string& output) {
+        close();
+        filePath   = path;
+        outputName = output;
+        hasParams  = false;
+        frames  = 0;
+        dropped = 0;
+        bytes   = 0;
+        full    = false;
+        failed  = false;
+        quit    = false;
+        head    = 0;
+        tail    = 0;
+        thread  = std::thread([this] { run(); });
+    }
+
+    // Queues one frame; `params` is copied only when `paramsKey` changed.
+    // With `wait` (offline renders) a full queue blocks until the writer
+    // catches up instead of dropping the frame.
+    void push(const unsigned char* rgb, int w, int h, double time, const std::string& params,
+              uint64_t paramsKey, bool wait = false) {
+        if (!isOpen() || full || failed) return;
+        size_t slot = head.load(std::memory_order_relaxed);
+        while (next(slot) == tail.load(std::memory_order_acquire)) {
+            if (!wait || failed) {
+                dropped++;
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Pending& p = queue[slot];
+        p.pixels.assign(rgb, rgb + (size_t)w * h * 3);
+        p.width  = w;
+        p.height = h;
+        p.time   = time;
+        p.paramsChanged = !hasParams || paramsKey != lastParamsKey;
+        if (p.paramsChanged) p.params = params;
+        hasParams     = true;
+        lastParamsKey = paramsKey;
+        head.store(next(slot), std::memory_order_release);
+    }
+
+    // Writes out the queued frames and finishes the file.
+    void close() {
+        if (!isOpen()) return;
+        quit = true;
+        thread.join();
+    }
+
+private:
+    struct Pending {
+        std::vector<unsigned char> pixels;
+        int         width = 0, height = 0;
+        double      time  = 0;
+        bool        paramsChanged = false;
+        std::string params;
+    };
+
+    std::vector<Pending> queue;
+    std::atomic<size_t>  head{0}, tail{0};
+    std::atomic<bool>    quit{false};
+    std::thread          thread;
+    std::string          filePath, outputName, errorText;
+    uint64_t             lastParamsKey = 0;       // producer side
+    bool                 hasParams     = false;
+
+    // Writer side
+    int              fd      = -1;
+    unsigned char*   base    = nullptr;
+    size_t           mapSize = 0;
+    RecordingHeader* header  = nullptr;
+    RecordingEntry*  entries = nullptr;
+    std::vector<unsigned char> prev;   // last written frame
+    int              prevW = 0, prevH = 0;
+    uint32_t         sinceKey = 0;
+
+    size_t next(size_t i) const { return (i + 1) % queue.size(); }
+
+    void run() {
+        if (!map()) {
+            unmap();
+            failed = true;
+            return;
+        }
+        for (;;) {
+            // quit is read first: every push() before close() is then visible
+            bool stopping = quit;
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                if (stopping) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+            write(queue[t]);
+            tail.store(next(t), std::memory_order_release);
+        }
+        unmap();
+    }
+
+    bool map() {
+        size_t indexBytes = sizeof(RecordingHeader) + (size_t)maxFrames * sizeof(RecordingEntry);
+        mapSize = std::max(budgetBytes, indexBytes + ((size_t)1 << 20));
+        fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            errorText = "cannot create " + filePath + ": " + std::strerror(errno);
+            return false;
+        }
+        if (!preallocateFile(fd, mapSize)) {
+            errorText = "cannot reserve " + ofToString(mapSize >> 20) + " MB for " + filePath;
+            return false;
+        }
+        void* m = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            errorText = "cannot map " + filePath + ": " + std::strerror(errno);
+            return false;
+        }
+        base    = (unsigned char*)m;
+        header  = (RecordingHeader*)base;
+        entries = (RecordingEntry*)(base + sizeof(RecordingHeader));
+        std::memcpy(header->magic, "OXFR", 4);
+        header->version     = RecordingHeader::kVersion;
+        header->capacity    = maxFrames;
+        header->keyInterval = keyInterval;
+        header->dataStart   = indexBytes;
+        header->dataEnd     = indexBytes;
+        std::strncpy(header->output, outputName.c_str(), sizeof(header->output) - 1);
+        bytes    = indexBytes;
+        prevW    = 0;
+        prevH    = 0;
+        sinceKey = 0;
+        return true;
+    }
+
+    void unmap() {
+        if (base) {
+            // No msync: the page cache writes the frames back on its own,
+            // and close() should not wait on the disk
+            uint64_t end = header->dataEnd;
+            munmap(base, mapSize);
+            if (ftruncate(fd, (off_t)end) != 0) ofLogWarning("FrameRecorder") << "cannot trim " << filePath;
+            base    = nullptr;
+            header  = nullptr;
+            entries = nullptr;
+        }
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    void write(Pending& p) {
+        size_t   n      = p.pixels.size();
+        uint32_t index  = header->count;
+        size_t   params = p.paramsChanged ? p.params.size() : 0;
+        if (index >= header->capacity || header->dataEnd + params + n > mapSize) {
+            full = true;
+            return;
+        }
+
+        unsigned char* dst = base + header->dataEnd;
+        std::memcpy(dst, p.params.data(), params);
+        unsigned char* payload = dst + params;
+
+        bool   key     = p.width != prevW || p.height != prevH || sinceKey >= keyInterval;
+        size_t encoded = key ? 0 : encodeDelta(prev.data(), p.pixels.data(), n, payload, n);
+        RecordingEntry& e = entries[index];
+        e.codec = RecordingEntry::Delta;
+        if (!encoded) {
+            std::memcpy(payload, p.pixels.data(), n);
+            encoded  = n;
+            e.codec  = RecordingEntry::Raw;
+            sinceKey = 0;
+        }
+        sinceKey++;
+
+        e.offset      = header->dataEnd;
+        e.bytes       = (uint32_t)encoded;
+        e.paramsBytes = (uint32_t)params;
+        e.time        = p.time;
+        e.width       = (uint16_t)p.width;
+        e.height      = (uint16_t)p.height;
+        header->dataEnd += params + encoded;
+        __atomic_store_n(&header->count, index + 1, __ATOMIC_RELEASE);
+
+        // The slot takes the old reference buffer; push() reuses its capacity
+        std::swap(prev, p.pixels);
+        prevW = p.width;
+        prevH = p.height;
+        frames++;
+        bytes = header->dataEnd;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// FramePlayer — random access to the frames of a .ofxr file.
+//
+// The file is mapped read-only, so opening is instant at any length and a
+// file still being recorded can be scrubbed up to its last committed frame.
+// frame() keeps the last decoded frame: stepping forward applies one delta,
+// any other seek decodes from the key frame before it.
+// ---------------------------------------------------------------------------
+struct FramePlayer {
+    ~FramePlayer() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            error = "cannot open " + path;
+            close();
+            return false;
+        }
+        mapSize = (size_t)st.st_size;
+        if (mapSize >= sizeof(RecordingHeader)) {
+            void* m = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+            if (m != MAP_FAILED) base = (const unsigned char*)m;
+        }
+        header = (const RecordingHeader*)base;
+        if (!base || std::memcmp(header->magic, "OXFR", 4) != 0
+            || header->version != RecordingHeader::kVersion
+            || sizeof(RecordingHeader) + (size_t)header->capacity * sizeof(RecordingEntry) > mapSize) {
+            error = path + " is not a recording";
+            close();
+            return false;
+        }
+        entries = (const RecordingEntry*)(base + sizeof(RecordingHeader));
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(const_cast<unsigned char*>(base), mapSize);
+        if (fd >= 0) ::close(fd);
+        base    = nullptr;
+        header  = nullptr;
+        entries = nullptr;
+        fd      = -1;
+        decoded = -1;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    // Committed frames; grows while the file is being recorded.
+    int size() const {
+        return header ? (int)__atomic_load_n(&header->count, __ATOMIC_ACQUIRE) : 0;
+    }
+
+    const RecordingEntry& entry(int n) const { return entries[n]; }
+    std::string output() const { return std::string(header->output, strnlen(header->output, sizeof(header->output))); }
+
+    // Decoded RGB of frame n (entry(n).width x height), or nullptr when the
+    // file is damaged.
+    const unsigned char* frame(int n) {
+        if (n == decoded) return pixels.data();
+        int start = n;
+        while (start > 0 && entries[start].codec != RecordingEntry::Raw) start--;
+        if (decoded >= start && decoded < n) start = decoded + 1;
+        decoded = -1;
+        pixels.resize((size_t)entries[n].width * entries[n].height * 3);
+        for (int i = start; i <= n; i++) {
+            if (!apply(entries[i])) return nullptr;
+        }
+        decoded = n;
+        return pixels.data();
+    }
+
+    // Params JSON in effect at frame n.
+    std::string params(int n) const {
+        while (n > 0 && entries[n].paramsBytes == 0) n--;
+        const RecordingEntry& e = entries[n];
+        if (!inFile(e, e.paramsBytes)) return std::string();
+        return std::string((const char*)base + e.offset, e.paramsBytes);
+    }
+
+    // Last frame with time <= t (0 before the first).
+    int findTime(double t) const {
+        int lo = 0, hi = size() - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (entries[mid].time <= t) lo = mid;
+            else                        hi = mid - 1;
+        }
+        return lo;
+    }
+
+private:
+    int                    fd      = -1;
+    const unsigned char*   base    = nullptr;
+    size_t                 mapSize = 0;
+    const RecordingHeader* header  = nullptr;
+    const RecordingEntry*  entries = nullptr;
+    std::vector<unsigned char> pixels;
+    int                    decoded = -1;
+
+    bool inFile(const RecordingEntry& e, size_t bytes) const {
+        return e.offset <= mapSize && bytes <= mapSize - e.offset;
+    }
+
+    bool apply(const RecordingEntry& e) {
+        size_t n = (size_t)e.width * e.height * 3;
+        if (n != pixels.size() || !inFile(e, (size_t)e.paramsBytes + e.bytes)) return false;
+        const unsigned char* payload = base + e.offset + e.paramsBytes;
+        if (e.codec == RecordingEntry::Raw) {
+            if (e.bytes != n) return false;
+            std::memcpy(pixels.data(), payload, n);
+            return true;
+        }
+        return decodeDelta(payload, e.bytes, pixels.data(), n);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Recording comparison — headless regression check between two builds.
+//
+//   ofxFilters --compare a.ofxr b.ofxr
+//
+// Matches frames by index (record both with `--render ... --record`, whose
+// time is frameIndex / fps) and reports frame count, size, pixel and param
+// mismatches. Exits 0 when identical, 1 when they differ, 2 on bad files.
+// ---------------------------------------------------------------------------
+inline bool parseCompareArgs(int argc, char* argv[], std::string& a, std::string& b) {
+    for (int i = 1; i + 2 < argc; i++) {
+        if (std::string(argv[i]) == "--compare") {
+            a = argv[i + 1];
+            b = argv[i + 2];
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int runCompare(const std::string& pathA, const std::string& pathB) {
+    FramePlayer a, b;
+    std::string error;
+    if (!a.open(pathA, error) || !b.open(pathB, error)) {
+        std::fprintf(stderr, "compare: %s\n", error.c_str());
+        return 2;
+    }
+    int frames = std::min(a.size(), b.size());
+    int differing = 0, paramsDiffering = 0, firstDiff = -1, maxDelta = 0;
+    for (int i = 0; i < frames; i++) {
+        const RecordingEntry& ea = a.entry(i);
+        const RecordingEntry& eb = b.entry(i);
+        const unsigned char*  fa = a.frame(i);
+        const unsigned char*  fb = b.frame(i);
+        if (!fa || !fb) {
+            std::fprintf(stderr, "compare: frame %d is damaged in %s\n", i, (fa ? pathB : pathA).c_str());
+            return 2;
+        }
+        bool same = ea.width == eb.width && ea.height == eb.height;
+        if (same) {
+            size_t n = (size_t)ea.width * ea.height * 3;
+            same = std::memcmp(fa, fb, n) == 0;
+            for (size_t j = 0; !same && j < n; j++) maxDelta = std::max(maxDelta, std::abs(fa[j] - fb[j]));
+        }
+        if (!same) {
+            differing++;
+            if (firstDiff < 0) firstDiff = i;
+        }
+        if ((ea.paramsBytes || eb.paramsBytes) && a.params(i) != b.params(i)) paramsDiffering++;
+    }
+    std::printf("compare: %d / %d frames, %d differ (max channel delta %d), %d param changes differ\n",
+                frames, std::max(a.size(), b.size()), differing, maxDelta, paramsDiffering);
+    if (firstDiff >= 0) std::printf("  first differing frame: %d\n", firstDiff);
+    return differing || paramsDiffering || a.size() != b.size() ? 1 : 0;
+}
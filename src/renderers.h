@@ -1,40 +1,99 @@
 #pragma once
 
 #include "ofMain.h"
+#include "profiler.h"
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 // ---------------------------------------------------------------------------
 // Renderer — base class. Reads from effectData and draws to screen.
+// With a Profiler attached, the caller times render() as "render/<name>";
+// subclasses may register finer stages of their own.
 // ---------------------------------------------------------------------------
 struct Renderer {
     bool        enabled = false;
     std::string name;
 
-    virtual void render(unsigned char* data, int w, int h,
+    Profiler* profiler    = nullptr;
+    int       renderStage = -1;
+
+    virtual void attachProfiler(Profiler* p) {
+        profiler = p;
+        if (p) renderStage = p->stage("render/" + name);
+    }
+
+    virtual void render(const unsigned char* data, int w, int h,
                         float dispX, float dispY, float dispW, float dispH) = 0;
     virtual ~Renderer() = default;
 };
 
 // ---------------------------------------------------------------------------
 // TextureRenderer — uploads effectData to a GPU texture and draws it.
+//
+// Uploads happen only when `data` changes (OutputBuffers hands out a new
+// buffer per published frame). With usePbo, the bytes are copied into a
+// write-only mapping of one of two alternating pixel buffer objects, mapped
+// with GL_MAP_INVALIDATE_BUFFER_BIT so the driver hands out fresh storage
+// instead of waiting on a buffer the GPU is still reading, and the texture
+// is filled from it asynchronously. Falls back to a direct loadData() when PBOs are missing;
+// both paths work on Mesa's software rasteriser (llvmpipe).
 // ---------------------------------------------------------------------------
 struct TextureRenderer : Renderer {
     ofTexture texture;
+    bool      usePbo = true;
+    int       uploadStage = -1;
 
     TextureRenderer() { name = "Texture"; enabled = true; }
 
+    void attachProfiler(Profiler* p) override {
+        Renderer::attachProfiler(p);
+        if (p) uploadStage = p->stage("render/Texture/upload");
+    }
+
     void allocate(int w, int h) {
         texture.allocate(w, h, GL_RGB);
+        pboSupported = ofIsGLProgrammableRenderer() || ofGLCheckExtension("GL_ARB_pixel_buffer_object");
+        if (pboSupported) {
+            for (auto& pbo : pbos) pbo.allocate((size_t)w * h * 3, GL_STREAM_DRAW);
+        }
+        uploaded = nullptr;
     }
 
-    void render(unsigned char* data, int w, int h,
+    bool pboActive() const { return usePbo && pboSupported; }
+
+    void render(const unsigned char* data, int w, int h,
                 float dispX, float dispY, float dispW, float dispH) override {
-        texture.loadData(data, w, h, GL_RGB);
+        if (data != uploaded) {
+            ProfileScope scope(profiler, uploadStage);
+            if (pboActive()) {
+                ofBufferObject& pbo = pbos[nextPbo];
+                nextPbo ^= 1;
+                size_t bytes = (size_t)w * h * 3;
+                void*  dst   = pbo.mapRange(0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                if (dst) {
+                    std::memcpy(dst, data, bytes);
+                    pbo.unmapRange();
+                } else {
+                    pbo.setData(bytes, data, GL_STREAM_DRAW);   // orphans the old storage
+                }
+                texture.loadData(pbo, GL_RGB, GL_UNSIGNED_BYTE);
+            } else {
+                texture.loadData(data, w, h, GL_RGB);
+            }
+            uploaded = data;
+        }
         ofSetColor(255);
         texture.draw(dispX, dispY, dispW, dispH);
     }
+
+private:
+    ofBufferObject       pbos[2];
+    int                  nextPbo      = 0;
+    bool                 pboSupported = false;
+    const unsigned char* uploaded     = nullptr;
 };
 
 // ---------------------------------------------------------------------------
@@ -50,18 +109,31 @@ struct TextureRenderer : Renderer {
 //   Each char is sampled from the centre of its cell in effectData,
 //   and drawn at exactly (dispX + c*cellW, dispY + (r+1)*cellH).
 //
+// Area sampling (areaSample): instead of the centre pixel, each cell takes
+// the mean color of every effectData pixel under it, read in O(1) from a
+// summed-area table built once per frame. Cost stays O(pixels) for any cell
+// size (table rows are kept only at cell-row edges), and glyphs no longer
+// flicker as displaced pixels cross cell centres.
+// Row tint then uses the mean of the centre cell rather than one pixel.
+//
 // Color modes:
-//   0 = monochrome (CRT green)  — color set once per frame
-//   1 = row-tinted (center px)  — color set once per row, sampled from center column
-//   2 = per-char color          — color set per character
+//   0 = monochrome (CRT green)
+//   1 = row-tinted (center px)  — sampled from the center column of each row
+//   2 = per-char color
+//
+// Drawing: every non-blank cell becomes one quad in a single mesh, textured
+// from ofBitmapFont's glyph atlas with the cell color as vertex color, so
+// all color modes are one draw call. Glyph quads are cut from the atlas
+// once; cells and mesh arrays keep their capacity between frames.
 //
-// Keys: 5=toggle, 6=cycle mode, m/n=cellW -/+, ,/.=char set
+// Keys: 5=toggle, 6=cycle mode, m/n=cellW -/+, ,/.=char set, b=area sampling
 // ---------------------------------------------------------------------------
 struct AsciiRenderer : Renderer {
     int cellW = 8;
     int cellH = 14;
     int colorMode    = 0;
     int charSetIndex = 0;
+    bool areaSample  = false;
 
     const std::vector<std::string> charSets = {
         " .:-=+*#%@",   // standard 10 levels
@@ -70,44 +142,217 @@ struct AsciiRenderer : Renderer {
         " .-+oO0@#",     // organic
     };
 
+    // One character cell: glyph plus the color it is drawn with.
+    struct Cell {
+        char          glyph;
+        unsigned char r, g, b;
+    };
+
+    // Cell grid from the last buildCells(), row-major numRows x numCols.
+    std::vector<Cell> cells;
+    int numCols = 0;
+    int numRows = 0;
+
+    int buildStage = -1;
+
     AsciiRenderer() { name = "Ascii"; }
 
-    void render(unsigned char* data, int w, int h,
-                float dispX, float dispY, float dispW, float dispH) override {
+    void attachProfiler(Profiler* p) override {
+        Renderer::attachProfiler(p);
+        if (p) buildStage = p->stage("render/Ascii/build");
+    }
 
+    // Samples effectData into `cells`. No GL calls, so it can run headless.
+    void buildCells(const unsigned char* data, int w, int h, float dispW, float dispH) {
         const std::string& chars = charSets[charSetIndex % (int)charSets.size()];
         int numLevels = (int)chars.size() - 1;
 
-        int numCols = std::max(1, (int)(dispW / cellW));
-        int numRows = std::max(1, (int)(dispH / cellH));
+        numCols = std::max(1, (int)(dispW / cellW));
+        numRows = std::max(1, (int)(dispH / cellH));
+        cells.resize((size_t)numCols * numRows);
 
-        // Set color once for monochrome mode
-        if (colorMode == 0) ofSetColor(0, 255, 0);
+        if (areaSample) buildSat(data, w, h);
 
         for (int r = 0; r < numRows; r++) {
-            float drawY = dispY + (r + 1) * cellH;  // Y = baseline of this row
+            int sy = ofClamp((int)((r + 0.5f) * h / numRows), 0, h - 1);
+            int y0, y1;
+            cellRowSpan(r, h, y0, y1);
 
             // Row-tinted: sample from the center column of this row.
             // Averaging across all columns cancels complementary colors → gray;
             // a single center sample preserves actual hue.
+            Cell tint = { 0, 0, 255, 0 };
             if (colorMode == 1) {
-                int sy  = ofClamp((int)((r + 0.5f) * h / numRows), 0, h - 1);
-                int idx = (sy * w + w / 2) * 3;
-                ofSetColor(data[idx], data[idx + 1], data[idx + 2]);
+                unsigned char mean[3];
+                const unsigned char* p = data + (sy * w + w / 2) * 3;
+                if (areaSample) {
+                    int cc = numCols / 2;
+                    boxMean(cc * w / numCols, y0, std::max(cc * w / numCols + 1, (cc + 1) * w / numCols),
+                            y1, w, mean);
+                    p = mean;
+                }
+                tint = { 0, p[0], p[1], p[2] };
             }
 
-            // Draw each character at its exact cell position
+            Cell* row = &cells[(size_t)r * numCols];
             for (int c = 0; c < numCols; c++) {
-                int sx = ofClamp((int)((c + 0.5f) * w / numCols), 0, w - 1);
-                int sy = ofClamp((int)((r + 0.5f) * h / numRows), 0, h - 1);
-                int idx = (sy * w + sx) * 3;
-                int brightness = (data[idx] + data[idx + 1] + data[idx + 2]) / 3;
+                unsigned char mean[3];
+                const unsigned char* p;
+                if (areaSample) {
+                    int x0 = c * w / numCols;
+                    boxMean(x0, y0, std::max(x0 + 1, (c + 1) * w / numCols), y1, w, mean);
+                    p = mean;
+                } else {
+                    int sx = ofClamp((int)((c + 0.5f) * w / numCols), 0, w - 1);
+                    p = data + (sy * w + sx) * 3;
+                }
+                int brightness = (p[0] + p[1] + p[2]) / 3;
                 int ci = std::min((brightness * numLevels) / 255, numLevels);
 
-                if (colorMode == 2) ofSetColor(data[idx], data[idx + 1], data[idx + 2]);
+                row[c] = colorMode == 2 ? Cell{ chars[ci], p[0], p[1], p[2] }
+                                        : Cell{ chars[ci], tint.r, tint.g, tint.b };
+            }
+        }
+    }
+
+    // Turns `cells` into glyph quads at the given display origin. CPU only:
+    // render() passes the renderer's ofIsVFlipped(), callers without a
+    // window get OF's default (flipped, y down).
+    void buildMesh(float dispX, float dispY, bool vFlipped = true) {
+        if (glyphVerts.empty() || vFlipped != glyphsFlipped) buildGlyphs(vFlipped);
+
+        auto& verts  = mesh.getVertices();
+        auto& tex    = mesh.getTexCoords();
+        auto& colors = mesh.getColors();
+        size_t maxVerts = cells.size() * kGlyphVerts;
+        verts.resize(maxVerts);
+        tex.resize(maxVerts);
+        colors.resize(maxVerts);
+
+        size_t n = 0;
+        for (int r = 0; r < numRows; r++) {
+            float drawY = dispY + (r + 1) * cellH;  // Y = baseline of this row
+            const Cell* row = &cells[(size_t)r * numCols];
+            for (int c = 0; c < numCols; c++) {
+                unsigned char g = (unsigned char)row[c].glyph;
+                if (g == ' ' || g >= kNumGlyphs) continue;
+
+                float drawX = dispX + c * cellW;
+                ofFloatColor color(row[c].r / 255.0f, row[c].g / 255.0f, row[c].b / 255.0f);
+                const glm::vec3* gv = &glyphVerts[(size_t)g * kGlyphVerts];
+                const glm::vec2* gt = &glyphTex[(size_t)g * kGlyphVerts];
+                for (int k = 0; k < kGlyphVerts; k++, n++) {
+                    verts[n]  = glm::vec3(gv[k].x + drawX, gv[k].y + drawY, 0);
+                    tex[n]    = gt[k];
+                    colors[n] = color;
+                }
+            }
+        }
+        verts.resize(n);
+        tex.resize(n);
+        colors.resize(n);
+    }
+
+    void render(const unsigned char* data, int w, int h,
+                float dispX, float dispY, float dispW, float dispH) override {
+        {
+            ProfileScope scope(profiler, buildStage);
+            buildCells(data, w, h, dispW, dispH);
+            buildMesh(dispX, dispY, ofIsVFlipped());
+        }
+
+        const ofTexture& atlas = ofBitmapFont::getTexture();
+        ofPushStyle();
+        ofEnableAlphaBlending();
+        ofSetColor(255);
+        atlas.bind();
+        mesh.draw();
+        atlas.unbind();
+        ofPopStyle();
+    }
+
+private:
+    // ofBitmapFont lays each character out as two triangles.
+    static const int kGlyphVerts = 6;
+    static const int kNumGlyphs  = 128;
+
+    // Summed-area table, (w+1) x RGB per stored row; the row for y holds
+    // sum of data[0..y)[0..x). Only cell-row edges are stored (satIndex maps
+    // y to a table row, -1 if absent). 32 bits hold 255 * w * h for anything
+    // up to 16 megapixels.
+    std::vector<uint32_t> sat;
+    std::vector<uint32_t> colSum;
+    std::vector<int>      satIndex;
 
-                ofDrawBitmapString(std::string(1, chars[ci]), dispX + c * cellW, drawY);
+    ofMesh                 mesh;
+    std::vector<glm::vec3> glyphVerts;   // per glyph, relative to its baseline origin
+    std::vector<glm::vec2> glyphTex;
+    bool                   glyphsFlipped = true;
+
+    // Rows [y0, y1) of effectData under cell row r.
+    void cellRowSpan(int r, int h, int& y0, int& y1) const {
+        y0 = r * h / numRows;
+        y1 = std::max(y0 + 1, (r + 1) * h / numRows);
+    }
+
+    // Accumulates per-column sums down the frame (one add per byte) and
+    // stores an x-prefix of them at each cell-row edge.
+    void buildSat(const unsigned char* data, int w, int h) {
+        satIndex.assign(h + 1, -1);
+        for (int r = 0; r < numRows; r++) {
+            int y0, y1;
+            cellRowSpan(r, h, y0, y1);
+            satIndex[y0] = satIndex[y1] = 0;
+        }
+        int numEdges = 0;
+        for (auto& i : satIndex) {
+            if (i >= 0) i = numEdges++;
+        }
+
+        size_t stride = (size_t)(w + 1) * 3;
+        sat.resize(stride * numEdges);
+        colSum.assign((size_t)w * 3, 0);
+        for (int y = 0; y <= h; y++) {
+            if (satIndex[y] >= 0) {
+                uint32_t* dst = &sat[(size_t)satIndex[y] * stride];
+                uint32_t run[3] = { 0, 0, 0 };
+                dst[0] = dst[1] = dst[2] = 0;
+                for (int x = 0; x < w; x++) {
+                    run[0] += colSum[x * 3 + 0]; dst[(x + 1) * 3 + 0] = run[0];
+                    run[1] += colSum[x * 3 + 1]; dst[(x + 1) * 3 + 1] = run[1];
+                    run[2] += colSum[x * 3 + 2]; dst[(x + 1) * 3 + 2] = run[2];
+                }
             }
+            if (y == h) break;
+            const unsigned char* src = data + (size_t)y * w * 3;
+            for (size_t i = 0; i < colSum.size(); i++) colSum[i] += src[i];
+        }
+    }
+
+    // Rounded mean RGB of data[y0..y1)[x0..x1); y0 and y1 must be cell-row edges.
+    void boxMean(int x0, int y0, int x1, int y1, int w, unsigned char* rgb) const {
+        size_t stride = (size_t)(w + 1) * 3;
+        const uint32_t* top    = &sat[(size_t)satIndex[y0] * stride];
+        const uint32_t* bottom = &sat[(size_t)satIndex[y1] * stride];
+        uint32_t area = (uint32_t)(x1 - x0) * (y1 - y0);
+        for (int ch = 0; ch < 3; ch++) {
+            uint32_t sum = bottom[x1 * 3 + ch] - bottom[x0 * 3 + ch]
+                         - top[x1 * 3 + ch]    + top[x0 * 3 + ch];
+            rgb[ch] = (unsigned char)((sum + area / 2) / area);
+        }
+    }
+
+    void buildGlyphs(bool vFlipped) {
+        glyphsFlipped = vFlipped;
+        glyphVerts.assign((size_t)kNumGlyphs * kGlyphVerts, glm::vec3());
+        glyphTex.assign((size_t)kNumGlyphs * kGlyphVerts, glm::vec2());
+        for (int g = 32; g < kNumGlyphs - 1; g++) {
+            ofMesh quad = ofBitmapFont::getMesh(std::string(1, (char)g), 0, 0,
+                                                OF_BITMAPMODE_SIMPLE, vFlipped);
+            if ((int)quad.getNumVertices() < kGlyphVerts) continue;
+            std::copy_n(quad.getVertices().begin(),  kGlyphVerts, glyphVerts.begin() + g * kGlyphVerts);
+            std::copy_n(quad.getTexCoords().begin(), kGlyphVerts, glyphTex.begin()   + g * kGlyphVerts);
         }
+        mesh.setMode(OF_PRIMITIVE_TRIANGLES);
     }
 };
@@ -0,0 +1,289 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define OFXFILTERS_X86 1
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define OFXFILTERS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(OFXFILTERS_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define OFXFILTERS_AVX2 1
+    #define OFXFILTERS_TARGET_AVX2 __attribute__((target("avx2")))
+    #define OFXFILTERS_SSSE3 1
+    #define OFXFILTERS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+// ---------------------------------------------------------------------------
+// RemapKernels — row kernels shared by the built-in effects.
+//
+// All coordinate updates in effects.h reduce to two shapes:
+//
+//   addWrap         v[i] = (v[i] + shift) mod m
+//   shiftByTables   c = col[i], r = row[i]
+//                   col[i] = (c + byRow[r]) mod w
+//                   row[i] = (r + byCol[c]) mod h
+//
+// Shifts and table entries are pre-normalised to [0, m), so the sum is in
+// [0, 2m) and the wrap is a compare + conditional subtract instead of `%`.
+//
+// The sub-pixel gather blends bytes with one more kernel:
+//
+//   lerpBytes       out[i] = (a[i] * (256 - t[i]) + b[i] * t[i] + 128) >> 8
+//
+// t is a Q8 weight in [0, 255]; out may alias a or b. Every variant
+// produces exactly the same integers as the scalar reference.
+//
+// The best variant for the CPU is picked at runtime: AVX2 (with hardware
+// gathers) or SSE2 on x86, NEON on ARM, scalar elsewhere.
+// ---------------------------------------------------------------------------
+struct RemapKernels {
+    const char* name;
+    void (*addWrap)(int* v, int n, int shift, int m);
+    void (*shiftByTables)(int* row, int* col, int n,
+                          const int* byRow, const int* byCol, int w, int h);
+    void (*lerpBytes)(const unsigned char* a, const unsigned char* b,
+                      const unsigned char* t, unsigned char* out, int n);
+};
+
+// Brings any integer shift into [0, m).
+inline int normalizeShift(int s, int m) {
+    s %= m;
+    return s < 0 ? s + m : s;
+}
+
+// --- scalar reference ------------------------------------------------------
+
+inline void addWrapScalar(int* v, int n, int shift, int m) {
+    for (int i = 0; i < n; i++) {
+        int x = v[i] + shift;
+        v[i] = x >= m ? x - m : x;
+    }
+}
+
+inline void shiftByTablesScalar(int* row, int* col, int n,
+                                const int* byRow, const int* byCol, int w, int h) {
+    for (int i = 0; i < n; i++) {
+        int r = row[i], c = col[i];
+        int nc = c + byRow[r];
+        int nr = r + byCol[c];
+        col[i] = nc >= w ? nc - w : nc;
+        row[i] = nr >= h ? nr - h : nr;
+    }
+}
+
+inline void lerpBytesScalar(const unsigned char* a, const unsigned char* b,
+                            const unsigned char* t, unsigned char* out, int n) {
+    for (int i = 0; i < n; i++) {
+        out[i] = (unsigned char)((a[i] * (256 - t[i]) + b[i] * t[i] + 128) >> 8);
+    }
+}
+
+// --- SSE2 ------------------------------------------------------------------
+
+#if defined(OFXFILTERS_X86)
+inline __m128i wrap4(__m128i x, __m128i m, __m128i mMinus1) {
+    return _mm_sub_epi32(x, _mm_and_si128(_mm_cmpgt_epi32(x, mMinus1), m));
+}
+
+inline void addWrapSse2(int* v, int n, int shift, int m) {
+    const __m128i s  = _mm_set1_epi32(shift);
+    const __m128i mm = _mm_set1_epi32(m);
+    const __m128i m1 = _mm_set1_epi32(m - 1);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(v + i)), s);
+        _mm_storeu_si128((__m128i*)(v + i), wrap4(x, mm, m1));
+    }
+    addWrapScalar(v + i, n - i, shift, m);
+}
+
+// SSE2 has no gather; table reads stay scalar, the add/wrap is vectorised.
+inline void shiftByTablesSse2(int* row, int* col, int n,
+                              const int* byRow, const int* byCol, int w, int h) {
+    const __m128i ww = _mm_set1_epi32(w), w1 = _mm_set1_epi32(w - 1);
+    const __m128i hh = _mm_set1_epi32(h), h1 = _mm_set1_epi32(h - 1);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i r  = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i c  = _mm_loadu_si128((const __m128i*)(col + i));
+        __m128i dc = _mm_set_epi32(byRow[row[i + 3]], byRow[row[i + 2]],
+                                   byRow[row[i + 1]], byRow[row[i]]);
+        __m128i dr = _mm_set_epi32(byCol[col[i + 3]], byCol[col[i + 2]],
+                                   byCol[col[i + 1]], byCol[col[i]]);
+        _mm_storeu_si128((__m128i*)(col + i), wrap4(_mm_add_epi32(c, dc), ww, w1));
+        _mm_storeu_si128((__m128i*)(row + i), wrap4(_mm_add_epi32(r, dr), hh, h1));
+    }
+    shiftByTablesScalar(row + i, col + i, n - i, byRow, byCol, w, h);
+}
+
+// 16-bit lanes; the products and their sum stay below 65536, so the
+// wrapping mullo/add give the exact unsigned result.
+inline __m128i lerp8x16(__m128i a, __m128i b, __m128i t) {
+    const __m128i one  = _mm_set1_epi16(256);
+    const __m128i half = _mm_set1_epi16(128);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(one, t)), _mm_mullo_epi16(b, t));
+    return _mm_srli_epi16(_mm_add_epi16(x, half), 8);
+}
+
+inline void lerpBytesSse2(const unsigned char* a, const unsigned char* b,
+                          const unsigned char* t, unsigned char* out, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i vt = _mm_loadu_si128((const __m128i*)(t + i));
+        __m128i lo = lerp8x16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero),
+                              _mm_unpacklo_epi8(vt, zero));
+        __m128i hi = lerp8x16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero),
+                              _mm_unpackhi_epi8(vt, zero));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+    lerpBytesScalar(a + i, b + i, t + i, out + i, n - i);
+}
+#endif
+
+// --- AVX2 ------------------------------------------------------------------
+
+#if defined(OFXFILTERS_AVX2)
+OFXFILTERS_TARGET_AVX2
+inline __m256i wrap8(__m256i x, __m256i m, __m256i mMinus1) {
+    return _mm256_sub_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(x, mMinus1), m));
+}
+
+OFXFILTERS_TARGET_AVX2
+inline void addWrapAvx2(int* v, int n, int shift, int m) {
+    const __m256i s  = _mm256_set1_epi32(shift);
+    const __m256i mm = _mm256_set1_epi32(m);
+    const __m256i m1 = _mm256_set1_epi32(m - 1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(v + i)), s);
+        _mm256_storeu_si256((__m256i*)(v + i), wrap8(x, mm, m1));
+    }
+    addWrapScalar(v + i, n - i, shift, m);
+}
+
+OFXFILTERS_TARGET_AVX2
+inline void shiftByTablesAvx2(int* row, int* col, int n,
+                              const int* byRow, const int* byCol, int w, int h) {
+    const __m256i ww = _mm256_set1_epi32(w), w1 = _mm256_set1_epi32(w - 1);
+    const __m256i hh = _mm256_set1_epi32(h), h1 = _mm256_set1_epi32(h - 1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i r  = _mm256_loadu_si256((const __m256i*)(row + i));
+        __m256i c  = _mm256_loadu_si256((const __m256i*)(col + i));
+        __m256i dc = _mm256_i32gather_epi32(byRow, r, 4);
+        __m256i dr = _mm256_i32gather_epi32(byCol, c, 4);
+        _mm256_storeu_si256((__m256i*)(col + i), wrap8(_mm256_add_epi32(c, dc), ww, w1));
+        _mm256_storeu_si256((__m256i*)(row + i), wrap8(_mm256_add_epi32(r, dr), hh, h1));
+    }
+    shiftByTablesScalar(row + i, col + i, n - i, byRow, byCol, w, h);
+}
+
+OFXFILTERS_TARGET_AVX2
+inline void lerpBytesAvx2(const unsigned char* a, const unsigned char* b,
+                          const unsigned char* t, unsigned char* out, int n) {
+    const __m256i one  = _mm256_set1_epi16(256);
+    const __m256i half = _mm256_set1_epi16(128);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i r[2];
+        for (int k = 0; k < 2; k++) {
+            __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(a + i + k * 16)));
+            __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(b + i + k * 16)));
+            __m256i vt = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(t + i + k * 16)));
+            __m256i x  = _mm256_add_epi16(_mm256_mullo_epi16(va, _mm256_sub_epi16(one, vt)),
+                                          _mm256_mullo_epi16(vb, vt));
+            r[k] = _mm256_srli_epi16(_mm256_add_epi16(x, half), 8);
+        }
+        // packus works per 128-bit lane; restore byte order afterwards
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0], r[1]), 0xD8);
+        _mm256_storeu_si256((__m256i*)(out + i), packed);
+    }
+    lerpBytesSse2(a + i, b + i, t + i, out + i, n - i);
+}
+#endif
+
+// --- NEON ------------------------------------------------------------------
+
+#if defined(OFXFILTERS_NEON)
+inline int32x4_t wrap4(int32x4_t x, int32x4_t m) {
+    uint32x4_t over = vcgeq_s32(x, m);
+    return vsubq_s32(x, vandq_s32(vreinterpretq_s32_u32(over), m));
+}
+
+inline void addWrapNeon(int* v, int n, int shift, int m) {
+    const int32x4_t s  = vdupq_n_s32(shift);
+    const int32x4_t mm = vdupq_n_s32(m);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_s32(v + i, wrap4(vaddq_s32(vld1q_s32(v + i), s), mm));
+    }
+    addWrapScalar(v + i, n - i, shift, m);
+}
+
+// NEON has no gather; table reads stay scalar, the add/wrap is vectorised.
+inline void shiftByTablesNeon(int* row, int* col, int n,
+                              const int* byRow, const int* byCol, int w, int h) {
+    const int32x4_t ww = vdupq_n_s32(w), hh = vdupq_n_s32(h);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int dcs[4] = { byRow[row[i]], byRow[row[i + 1]], byRow[row[i + 2]], byRow[row[i + 3]] };
+        int drs[4] = { byCol[col[i]], byCol[col[i + 1]], byCol[col[i + 2]], byCol[col[i + 3]] };
+        int32x4_t r = vld1q_s32(row + i);
+        int32x4_t c = vld1q_s32(col + i);
+        vst1q_s32(col + i, wrap4(vaddq_s32(c, vld1q_s32(dcs)), ww));
+        vst1q_s32(row + i, wrap4(vaddq_s32(r, vld1q_s32(drs)), hh));
+    }
+    shiftByTablesScalar(row + i, col + i, n - i, byRow, byCol, w, h);
+}
+
+// (a << 8) - a*t + b*t never exceeds 65280; vrshrn adds the 128 and shifts.
+inline void lerpBytesNeon(const unsigned char* a, const unsigned char* b,
+                          const unsigned char* t, unsigned char* out, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint8x8_t  va = vld1_u8(a + i), vb = vld1_u8(b + i), vt = vld1_u8(t + i);
+        uint16x8_t x  = vshll_n_u8(va, 8);
+        x = vmlsl_u8(x, va, vt);
+        x = vmlal_u8(x, vb, vt);
+        vst1_u8(out + i, vrshrn_n_u16(x, 8));
+    }
+    lerpBytesScalar(a + i, b + i, t + i, out + i, n - i);
+}
+#endif
+
+// --- dispatch --------------------------------------------------------------
+
+inline const RemapKernels& scalarKernels() {
+    static const RemapKernels k = { "scalar", addWrapScalar, shiftByTablesScalar, lerpBytesScalar };
+    return k;
+}
+
+inline const RemapKernels& bestKernels() {
+#if defined(OFXFILTERS_AVX2)
+    static const RemapKernels avx2 = { "avx2", addWrapAvx2, shiftByTablesAvx2, lerpBytesAvx2 };
+    if (__builtin_cpu_supports("avx2")) return avx2;
+#endif
+#if defined(OFXFILTERS_X86)
+    static const RemapKernels sse2 = { "sse2", addWrapSse2, shiftByTablesSse2, lerpBytesSse2 };
+    return sse2;
+#elif defined(OFXFILTERS_NEON)
+    static const RemapKernels neon = { "neon", addWrapNeon, shiftByTablesNeon, lerpBytesNeon };
+    return neon;
+#else
+    return scalarKernels();
+#endif
+}
+
+inline const RemapKernels*& activeKernelsSlot() {
+    static const RemapKernels* k = &bestKernels();
+    return k;
+}
+
+// Kernels used by the effects. Switch only between frames.
+inline const RemapKernels& remapKernels() { return *activeKernelsSlot(); }
+inline void useSimdKernels(bool on) { activeKernelsSlot() = on ? &bestKernels() : &scalarKernels(); }
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "ofMain.h"
+#include "effects.h"
+#include "pipeline.h"
+#include "history.h"
+#include "ingest.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+
+// ---------------------------------------------------------------------------
+// Verify mode — randomised equivalence check of every optimised remap path
+// against the scalar reference. Exits non-zero on any byte mismatch.
+//
+//   ofxFilters --verify [--verify-cases 300] [--seed 1] [--threads N]
+//
+// Each case draws a frame size, a history layout (all three compact
+// formats), a chain of the built-in effects (random order or the fused
+// kernel's canonical one, random enabled set, parameters, sub-pixel modes,
+// paused Wave), a designWidth for resolution scaling and the sine mode.
+// Two identical chains then run several frames at random times, with a
+// parameter change part way:
+//
+//   reference   generic span loop, scalar kernels, no LUT, calling thread
+//   candidate   SIMD kernels, LUT and fused kernel each on or off, on a
+//               WorkerPool in dynamic or deterministic scheduling
+//
+// Fixed-point and float sine are compared like for like, never against
+// each other. FrameIngest's SIMD conversions are checked against the
+// scalar ones over random sizes and pixel formats as well.
+// ---------------------------------------------------------------------------
+struct VerifyOptions {
+    int      cases   = 300;
+    unsigned seed    = 1;
+    int      threads = 0;
+};
+
+inline bool parseVerifyArgs(int argc, char* argv[], VerifyOptions& o) {
+    bool verify = false;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if      (a == "--verify")                     verify    = true;
+        else if (a == "--verify-cases" && hasValue)   o.cases   = std::max(1, ofToInt(argv[++i]));
+        else if (a == "--seed"         && hasValue)   o.seed    = (unsigned)ofToInt(argv[++i]);
+        else if (a == "--threads"      && hasValue)   o.threads = ofToInt(argv[++i]);
+    }
+    return verify;
+}
+
+// Builds the chain for `seed` into `owned` / `chain`; the same seed always
+// gives the same chain, so reference and candidate start out identical.
+inline std::string buildVerifyChain(unsigned seed, int numFrames,
+                                    std::vector<std::unique_ptr<EffectModule>>& owned, EffectChain& chain) {
+    std::mt19937 rng(seed);
+    auto pick = [&](int n) { return (int)(rng() % n); };
+    auto unit = [&] { return (float)(rng() % 10001) / 10000.0f; };
+
+    auto* wave = new WaveEffect();
+    wave->speed   = unit() * 6.0f;
+    wave->hAmount = unit() * 30.0f;
+    wave->vAmount = unit() * 30.0f;
+    if (pick(3) == 0) wave->setPaused(true, unit() * 100.0f);
+
+    auto* slitscan  = new SlitscanEffect(numFrames);
+    slitscan->depth = 1 + pick(std::max(numFrames - 1, 1));
+
+    auto* block        = new BlockDisplaceEffect();
+    block->blockSize   = 1 + pick(64);
+    block->blockAmount = unit() * 40.0f;
+
+    auto* rgb        = new RgbSplitEffect();
+    rgb->shiftAmount = pick(48);
+
+    auto* feedback = new FeedbackEffect();
+    feedback->mix  = unit();
+    feedback->zoom = 0.8f + unit() * 0.4f;
+
+    std::vector<EffectModule*> modules = { wave, slitscan, block, rgb, feedback };
+    for (auto* m : modules) {
+        m->enabled  = pick(2) == 1;
+        m->subpixel = m->supportsSubpixel() && pick(4) == 0;
+    }
+    if (pick(2)) std::shuffle(modules.begin(), modules.end(), rng);
+
+    owned.clear();
+    chain.modules = modules;
+    std::string name;
+    for (auto* m : modules) {
+        owned.emplace_back(m);
+        if (m->enabled) name += (name.empty() ? "" : "+") + m->name + (m->subpixel ? "(sub)" : "");
+    }
+    return name.empty() ? "none" : name;
+}
+
+// Applies the same random change to a chain built by buildVerifyChain().
+inline void mutateVerifyChain(unsigned seed, EffectChain& chain, int numFrames) {
+    std::mt19937 rng(seed);
+    EffectModule* m = chain.modules[rng() % chain.modules.size()];
+    if (rng() % 2) m->enabled = !m->enabled;
+    if (auto* s = dynamic_cast<SlitscanEffect*>(m))      s->depth       = 1 + (int)(rng() % std::max(numFrames - 1, 1));
+    if (auto* r = dynamic_cast<RgbSplitEffect*>(m))      r->shiftAmount = (int)(rng() % 48);
+    if (auto* b = dynamic_cast<BlockDisplaceEffect*>(m)) b->blockSize   = 1 + (int)(rng() % 64);
+    if (auto* w = dynamic_cast<WaveEffect*>(m))          w->setPaused(!w->paused, (float)(rng() % 1000) / 10.0f);
+}
+
+inline int runVerify(const VerifyOptions& o) {
+    const int kFrames = 5;
+
+    WorkerPool   pool(o.threads);
+    std::mt19937 rng(o.seed);
+    auto pick = [&](int n) { return (int)(rng() % n); };
+    int failures = 0;
+
+    for (int c = 0; c < o.cases; c++) {
+        int w = 1 + pick(300), h = 1 + pick(220);
+        size_t bytes = (size_t)w * h * 3;
+
+        // A few full frames and, for compact formats, older ones behind them
+        FrameHistory history;
+        auto  format   = (FrameHistory::Format)pick(FrameHistory::kNumFormats);
+        int   recent   = 2 + pick(10);
+        float budgetMB = (float)(bytes * (recent + 1 + pick(16))) / (1024.0f * 1024.0f);
+        history.configure(w, h, budgetMB, recent, format);
+        std::vector<unsigned char> noise(bytes);
+        auto pushNoise = [&] {
+            for (auto& b : noise) b = (unsigned char)rng();
+            history.pushFrame(noise.data());
+        };
+        for (int i = 0; i < history.depth(); i++) pushNoise();
+
+        unsigned chainSeed = (unsigned)rng();
+        std::vector<std::unique_ptr<EffectModule>> refOwned, candOwned;
+        EffectChain reference, candidate;
+        std::string name = buildVerifyChain(chainSeed, history.depth(), refOwned, reference);
+        buildVerifyChain(chainSeed, history.depth(), candOwned, candidate);
+        reference.designWidth = candidate.designWidth = pick(3) == 0 ? 0 : 16 + pick(1400);
+        reference.useLut   = false;
+        reference.useFused = false;
+        candidate.useLut   = pick(4) != 0;
+        candidate.useFused = pick(4) != 0;
+        bool deterministic = pick(2) == 1;
+        useFixedPointSine(pick(4) == 0);
+
+        OutputBuffers refOut, candOut;
+        refOut.allocate(w, h);
+        candOut.allocate(w, h);
+
+        float time = (float)pick(10000) / 100.0f;
+        for (int frame = 0; frame < kFrames; frame++) {
+            if (frame == kFrames / 2) {
+                unsigned mutation = (unsigned)rng();
+                mutateVerifyChain(mutation, reference, history.depth());
+                mutateVerifyChain(mutation, candidate, history.depth());
+            }
+            if (pick(2)) pushNoise();
+            time += (float)pick(200) / 100.0f;
+
+            RemapFrame f = { history.byAge(), history.recentDepth(), history.depth(), &history,
+                             refOut.back(), w, h, time, refOut.front() };
+            useSimdKernels(false);
+            reference.process(f);
+
+            f.dst      = candOut.back();
+            f.feedback = candOut.front();
+            useSimdKernels(true);
+            candidate.process(f, pool, deterministic);
+
+            if (std::memcmp(refOut.back(), candOut.back(), bytes) != 0) {
+                std::fprintf(stderr,
+                             "verify: case %d frame %d differs: %s at %dx%d, designWidth %d, %s history, "
+                             "%s kernels, %s, %s sine, %s scheduling\n",
+                             c, frame, name.c_str(), w, h, candidate.designWidth,
+                             FrameHistory::formatName(format), remapKernels().name,
+                             candidate.usingLut() ? "baked" : candidate.usingFused() ? "fused" : "live",
+                             fixedPointSine() ? "fixed" : "float", deterministic ? "deterministic" : "dynamic");
+                failures++;
+                break;
+            }
+            refOut.publish();
+            candOut.publish();
+        }
+    }
+    useFixedPointSine(false);
+
+    // Decoded-frame ingest: scalar vs. SIMD conversion and scaling
+    const ofPixelFormat formats[] = { OF_PIXELS_RGB, OF_PIXELS_BGR, OF_PIXELS_RGBA, OF_PIXELS_BGRA };
+    FrameIngest scalar, best;
+    scalar.kernels = &scalarIngestKernels();
+    best.kernels   = &bestIngestKernels();
+    for (int c = 0; c < o.cases; c++) {
+        int srcW = 1 + pick(400), srcH = 1 + pick(300);
+        int w    = pick(2) ? srcW : 1 + pick(300);
+        int h    = w == srcW ? srcH : 1 + pick(220);
+        ofPixels px;
+        px.allocate(srcW, srcH, formats[pick(4)]);
+        for (size_t i = 0; i < px.size(); i++) px.getData()[i] = (unsigned char)rng();
+        std::vector<unsigned char> a((size_t)w * h * 3), b((size_t)w * h * 3);
+        scalar.convert(px, a.data(), w, h);
+        best.convert(px, b.data(), w, h);
+        if (a != b) {
+            std::fprintf(stderr, "verify: %s ingest differs from scalar, %dx%d (%d channels) -> %dx%d\n",
+                         best.kernels->name, srcW, srcH, (int)px.getNumChannels(), w, h);
+            failures++;
+        }
+    }
+
+    std::printf("verify: %d remap and %d ingest cases, %s / %s kernels, %d threads: %d failure(s)\n",
+                o.cases, o.cases, remapKernels().name, bestIngestKernels().name,
+                pool.threadCount(), failures);
+    return failures > 0 ? 1 : 0;
+}
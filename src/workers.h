@@ -0,0 +1,178 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// WorkerPool — persistent threads that run a batch of independent tasks.
+//
+// run(numTasks, fn) calls fn(task, worker) once for every task in
+// [0, numTasks) and returns when all of them are done. The calling thread
+// takes part as worker 0, so threadCount() == 1 means "no extra threads".
+//
+// Scheduling:
+//   dynamic        — workers pull the next task from a shared counter.
+//   deterministic  — task t always runs on worker t % threadCount(), in
+//                    increasing order. Same task→worker mapping every frame.
+// ---------------------------------------------------------------------------
+struct WorkerPool {
+    WorkerPool() = default;
+    explicit WorkerPool(int numThreads) { setThreadCount(numThreads); }
+    ~WorkerPool() { stopThreads(); }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // n <= 0 picks one thread per hardware core.
+    void setThreadCount(int n) {
+        if (n <= 0) n = std::max(1, (int)std::thread::hardware_concurrency());
+        if (n == threadCount()) return;
+        stopThreads();
+        quit = false;
+        for (int i = 1; i < n; i++) {
+            threads.emplace_back([this, i, gen = generation] { workerLoop(i, gen); });
+        }
+    }
+
+    int threadCount() const { return (int)threads.size() + 1; }
+
+    void run(int numTasks, const std::function<void(int task, int worker)>& fn,
+             bool deterministic = false) {
+        if (numTasks <= 0) return;
+        if (threads.empty()) {
+            for (int t = 0; t < numTasks; t++) fn(t, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job          = &fn;
+            jobTasks     = numTasks;
+            jobStatic    = deterministic;
+            nextTask     = 0;
+            pending      = (int)threads.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex               mutex;
+    std::condition_variable  wake, done;
+
+    const std::function<void(int, int)>* job = nullptr;
+    int              jobTasks   = 0;
+    bool             jobStatic  = false;
+    std::atomic<int> nextTask{0};
+    int              pending    = 0;
+    unsigned         generation = 0;
+    bool             quit       = false;
+
+    void work(int worker) {
+        if (jobStatic) {
+            int stride = threadCount();
+            for (int t = worker; t < jobTasks; t += stride) (*job)(t, worker);
+        } else {
+            for (int t = nextTask++; t < jobTasks; t = nextTask++) (*job)(t, worker);
+        }
+    }
+
+    // `seen` is the generation at spawn time; reading it inside the thread
+    // could miss a run() posted before the thread got scheduled.
+    void workerLoop(int worker, unsigned seen) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            work(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending--;
+            }
+            done.notify_one();
+        }
+    }
+
+    void stopThreads() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+        threads.clear();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// BackgroundJob — one persistent thread that runs one job at a time, so the
+// caller can carry on (e.g. draw) while the job drives a WorkerPool.
+//
+// post() waits for the previous job before handing over the next one.
+// ---------------------------------------------------------------------------
+struct BackgroundJob {
+    BackgroundJob() : thread([this] { loop(); }) {}
+    ~BackgroundJob() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    BackgroundJob(const BackgroundJob&) = delete;
+    BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+    void post(std::function<void()> fn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return !job; });
+        job = std::move(fn);
+        lock.unlock();
+        wake.notify_one();
+    }
+
+    bool busy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (bool)job;
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return !job; });
+    }
+
+private:
+    std::mutex              mutex;
+    std::condition_variable wake, done;
+    std::function<void()>   job;
+    bool                    quit = false;
+    std::thread             thread;   // last: starts after the members above exist
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return quit || job; });
+            if (quit) return;
+            lock.unlock();
+            job();
+            lock.lock();
+            job = nullptr;
+            done.notify_all();
+        }
+    }
+};